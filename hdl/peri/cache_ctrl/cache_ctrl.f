@@ -0,0 +1,2 @@
+file cache_ctrl.v
+file cachectrl_regs.v
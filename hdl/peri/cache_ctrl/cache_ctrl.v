@@ -0,0 +1,82 @@
+/*****************************************************************************\
+|                        Copyright (C) 2021 Luke Wren                         |
+|                     SPDX-License-Identifier: Apache-2.0                     |
+\*****************************************************************************/
+
+// Cache maintenance registers. The shared cache has no maintenance port, so
+// software cleans and evicts its lines by reading aliasing addresses (see
+// cache.h). This block tells it the cache geometry, and counts line fills
+// from the alias region, so software can tell when a set is entirely full of
+// alias lines, whatever the replacement policy. The per-core instruction
+// caches can be invalidated directly.
+
+`default_nettype none
+
+module cache_ctrl #(
+	parameter CACHE_SIZE_BYTES = 1 << 12,
+	parameter CACHE_N_WAYS     = 2,
+	parameter CACHE_LINE_BYTES = 16
+) (
+	input  wire        clk,
+	input  wire        rst_n,
+
+	input  wire        apbs_psel,
+	input  wire        apbs_penable,
+	input  wire        apbs_pwrite,
+	input  wire [15:0] apbs_paddr,
+	input  wire [31:0] apbs_pwdata,
+	output wire [31:0] apbs_prdata,
+	output wire        apbs_pready,
+	output wire        apbs_pslverr,
+
+	// Shared cache line fill from the eviction region
+	input  wire        evict_fill,
+
+	output wire [1:0]  icache_invalidate
+);
+
+localparam [4:0] SIZE_LOG2 = $clog2(CACHE_SIZE_BYTES);
+localparam [1:0] WAYS_LOG2 = $clog2(CACHE_N_WAYS);
+localparam [3:0] LINE_LOG2 = $clog2(CACHE_LINE_BYTES);
+
+wire [1:0] icache_inval_wdata;
+wire       icache_inval_wen;
+
+reg [31:0] evict_fills;
+
+always @ (posedge clk or negedge rst_n) begin
+	if (!rst_n) begin
+		evict_fills <= 32'h0;
+	end else if (evict_fill) begin
+		evict_fills <= evict_fills + 32'h1;
+	end
+end
+
+cachectrl_regs regs (
+	.clk                  (clk),
+	.rst_n                (rst_n),
+
+	.apbs_psel            (apbs_psel),
+	.apbs_penable         (apbs_penable),
+	.apbs_pwrite          (apbs_pwrite),
+	.apbs_paddr           (apbs_paddr),
+	.apbs_pwdata          (apbs_pwdata),
+	.apbs_prdata          (apbs_prdata),
+	.apbs_pready          (apbs_pready),
+	.apbs_pslverr         (apbs_pslverr),
+
+	.geometry_size_log2_i (SIZE_LOG2),
+	.geometry_ways_log2_i (WAYS_LOG2),
+	.geometry_line_log2_i (LINE_LOG2),
+	.icache_inval_o       (icache_inval_wdata),
+	.icache_inval_wen     (icache_inval_wen),
+	.evict_fills_i        (evict_fills)
+);
+
+assign icache_invalidate = icache_inval_wdata & {2{icache_inval_wen}};
+
+endmodule
+
+`ifndef YOSYS
+`default_nettype wire
+`endif
@@ -0,0 +1,88 @@
+/*******************************************************************************
+*                       REGISTER BLOCK, WRITTEN BY HAND                        *
+*        Laid out like regblock output, but not generated by regblock.         *
+*          Keep in step with cachectrl_regs.yml when editing either.           *
+*******************************************************************************/
+
+// Block name           : cachectrl
+// Bus type             : apb
+// Bus data width       : 32
+// Bus address width    : 16
+
+module cachectrl_regs (
+	input wire clk,
+	input wire rst_n,
+	
+	// APB Port
+	input wire apbs_psel,
+	input wire apbs_penable,
+	input wire apbs_pwrite,
+	input wire [15:0] apbs_paddr,
+	input wire [31:0] apbs_pwdata,
+	output wire [31:0] apbs_prdata,
+	output wire apbs_pready,
+	output wire apbs_pslverr,
+	
+	// Register interfaces
+	input wire [4:0] geometry_size_log2_i,
+	input wire [1:0] geometry_ways_log2_i,
+	input wire [3:0] geometry_line_log2_i,
+	output reg [1:0] icache_inval_o,
+	output reg icache_inval_wen,
+	input wire [31:0] evict_fills_i
+);
+
+// APB adapter
+wire [31:0] wdata = apbs_pwdata;
+reg [31:0] rdata;
+wire wen = apbs_psel && apbs_penable && apbs_pwrite;
+wire ren = apbs_psel && apbs_penable && !apbs_pwrite;
+wire [15:0] addr = apbs_paddr & 16'hc;
+assign apbs_prdata = rdata;
+assign apbs_pready = 1'b1;
+assign apbs_pslverr = 1'b0;
+
+localparam ADDR_GEOMETRY = 0;
+localparam ADDR_ICACHE_INVAL = 4;
+localparam ADDR_EVICT_FILLS = 8;
+
+wire __geometry_wen = wen && addr == ADDR_GEOMETRY;
+wire __geometry_ren = ren && addr == ADDR_GEOMETRY;
+wire __icache_inval_wen = wen && addr == ADDR_ICACHE_INVAL;
+wire __icache_inval_ren = ren && addr == ADDR_ICACHE_INVAL;
+wire __evict_fills_wen = wen && addr == ADDR_EVICT_FILLS;
+wire __evict_fills_ren = ren && addr == ADDR_EVICT_FILLS;
+
+wire [4:0] geometry_size_log2_wdata = wdata[4:0];
+wire [4:0] geometry_size_log2_rdata;
+wire [1:0] geometry_ways_log2_wdata = wdata[9:8];
+wire [1:0] geometry_ways_log2_rdata;
+wire [3:0] geometry_line_log2_wdata = wdata[19:16];
+wire [3:0] geometry_line_log2_rdata;
+wire [31:0] __geometry_rdata = {12'h0, geometry_line_log2_rdata, 6'h0, geometry_ways_log2_rdata, 3'h0, geometry_size_log2_rdata};
+assign geometry_size_log2_rdata = geometry_size_log2_i;
+assign geometry_ways_log2_rdata = geometry_ways_log2_i;
+assign geometry_line_log2_rdata = geometry_line_log2_i;
+
+wire [1:0] icache_inval_wdata = wdata[1:0];
+wire [1:0] icache_inval_rdata;
+wire [31:0] __icache_inval_rdata = {30'h0, icache_inval_rdata};
+assign icache_inval_rdata = 2'h0;
+
+wire [31:0] evict_fills_wdata = wdata[31:0];
+wire [31:0] evict_fills_rdata;
+wire [31:0] __evict_fills_rdata = {evict_fills_rdata};
+assign evict_fills_rdata = evict_fills_i;
+
+always @ (*) begin
+	case (addr)
+		ADDR_GEOMETRY: rdata = __geometry_rdata;
+		ADDR_ICACHE_INVAL: rdata = __icache_inval_rdata;
+		ADDR_EVICT_FILLS: rdata = __evict_fills_rdata;
+		default: rdata = 32'h0;
+	endcase
+	icache_inval_wen = __icache_inval_wen;
+	icache_inval_o = icache_inval_wdata;
+end
+
+endmodule
@@ -0,0 +1,2 @@
+file dma.v
+file dma_regs.v
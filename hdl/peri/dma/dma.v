@@ -0,0 +1,341 @@
+/*****************************************************************************\
+|                        Copyright (C) 2021 Luke Wren                         |
+|                     SPDX-License-Identifier: Apache-2.0                     |
+\*****************************************************************************/
+
+// Two-channel DMA. An AHB-Lite master, which shares the system cache with the
+// processors, plus APB registers for configuration.
+//
+// Each transfer is a single read followed by a single write, of a byte,
+// halfword or word. Channels with work to do are served round-robin, one
+// transfer at a time. A channel with READ_ZERO set skips its reads and writes
+// zeroes, e.g. to feed dummy bytes to the SPI.
+//
+// The UART and SPI don't have DREQ outputs we can use here, so a channel can
+// instead be paced from any status register: before each transfer the channel
+// reads PACE_ADDR, and only goes ahead if (data & PACE_MASK) == PACE_MATCH,
+// e.g. "TX FIFO not full". Otherwise it lets the other channel have a turn,
+// and backs off before polling again: 1 cycle after the first failed check,
+// doubling with each consecutive failure up to 64 cycles, and reset by a
+// successful check. So a channel waiting on a slow peripheral (e.g. 133
+// cycles per byte for the UART at 3 Mbaud) only takes a couple of bus slots
+// per transfer from the processors, rather than polling continuously.
+//
+// The DMA only reaches the system cache: SDRAM, XIP and the peripherals. The
+// TCMs are private to each core. Below the SDRAM base, the cache would alias
+// addresses into SDRAM, so transfers there fail with an error instead, the
+// same as a bus error.
+
+`default_nettype none
+
+module dma (
+	input  wire        clk,
+	input  wire        rst_n,
+
+	input  wire        apbs_psel,
+	input  wire        apbs_penable,
+	input  wire        apbs_pwrite,
+	input  wire [15:0] apbs_paddr,
+	input  wire [31:0] apbs_pwdata,
+	output wire [31:0] apbs_prdata,
+	output wire        apbs_pready,
+	output wire        apbs_pslverr,
+
+	input  wire        ahblm_hready,
+	input  wire        ahblm_hresp,
+	output reg  [31:0] ahblm_haddr,
+	output reg         ahblm_hwrite,
+	output reg  [1:0]  ahblm_htrans,
+	output reg  [2:0]  ahblm_hsize,
+	output wire [2:0]  ahblm_hburst,
+	output wire [3:0]  ahblm_hprot,
+	output wire        ahblm_hmastlock,
+	output wire [31:0] ahblm_hwdata,
+	input  wire [31:0] ahblm_hrdata,
+
+	output wire        irq
+);
+
+localparam N_CH = 2;
+
+// ----------------------------------------------------------------------------
+// Registers
+
+wire [N_CH-1:0]    ctrl_en;
+wire [2*N_CH-1:0]  ctrl_size;
+wire [N_CH-1:0]    ctrl_incr_read;
+wire [N_CH-1:0]    ctrl_incr_write;
+wire [N_CH-1:0]    ctrl_pace;
+wire [N_CH-1:0]    ctrl_irq_en;
+wire [N_CH-1:0]    ctrl_read_zero;
+wire [N_CH-1:0]    ctrl_busy;
+reg  [N_CH-1:0]    ctrl_err_set;
+wire [N_CH-1:0]    ctrl_err;
+wire [32*N_CH-1:0] pace_addr;
+wire [32*N_CH-1:0] pace_mask;
+wire [32*N_CH-1:0] pace_match;
+
+reg  [32*N_CH-1:0] read_addr;
+reg  [32*N_CH-1:0] write_addr;
+reg  [32*N_CH-1:0] count;
+
+wire [32*N_CH-1:0] read_addr_wdata;
+wire [N_CH-1:0]    read_addr_wen;
+wire [32*N_CH-1:0] write_addr_wdata;
+wire [N_CH-1:0]    write_addr_wen;
+wire [32*N_CH-1:0] count_wdata;
+wire [N_CH-1:0]    count_wen;
+
+wire [N_CH-1:0]    intr;
+reg  [N_CH-1:0]    intr_set;
+
+dma_regs regs (
+	.clk                   (clk),
+	.rst_n                 (rst_n),
+
+	.apbs_psel             (apbs_psel),
+	.apbs_penable          (apbs_penable),
+	.apbs_pwrite           (apbs_pwrite),
+	.apbs_paddr            (apbs_paddr),
+	.apbs_pwdata           (apbs_pwdata),
+	.apbs_prdata           (apbs_prdata),
+	.apbs_pready           (apbs_pready),
+	.apbs_pslverr          (apbs_pslverr),
+
+	.ch0_read_addr_i       (read_addr[0 +: 32]),
+	.ch0_read_addr_o       (read_addr_wdata[0 +: 32]),
+	.ch0_read_addr_wen     (read_addr_wen[0]),
+	.ch0_read_addr_ren     (/* unused */),
+	.ch0_write_addr_i      (write_addr[0 +: 32]),
+	.ch0_write_addr_o      (write_addr_wdata[0 +: 32]),
+	.ch0_write_addr_wen    (write_addr_wen[0]),
+	.ch0_write_addr_ren    (/* unused */),
+	.ch0_count_i           (count[0 +: 32]),
+	.ch0_count_o           (count_wdata[0 +: 32]),
+	.ch0_count_wen         (count_wen[0]),
+	.ch0_count_ren         (/* unused */),
+	.ch0_ctrl_en_o         (ctrl_en[0]),
+	.ch0_ctrl_size_o       (ctrl_size[0 +: 2]),
+	.ch0_ctrl_incr_read_o  (ctrl_incr_read[0]),
+	.ch0_ctrl_incr_write_o (ctrl_incr_write[0]),
+	.ch0_ctrl_pace_o       (ctrl_pace[0]),
+	.ch0_ctrl_irq_en_o     (ctrl_irq_en[0]),
+	.ch0_ctrl_read_zero_o  (ctrl_read_zero[0]),
+	.ch0_ctrl_busy_i       (ctrl_busy[0]),
+	.ch0_ctrl_err_o        (ctrl_err[0]),
+	.ch0_ctrl_err_set      (ctrl_err_set[0]),
+	.ch0_pace_addr_o       (pace_addr[0 +: 32]),
+	.ch0_pace_mask_o       (pace_mask[0 +: 32]),
+	.ch0_pace_match_o      (pace_match[0 +: 32]),
+
+	.ch1_read_addr_i       (read_addr[32 +: 32]),
+	.ch1_read_addr_o       (read_addr_wdata[32 +: 32]),
+	.ch1_read_addr_wen     (read_addr_wen[1]),
+	.ch1_read_addr_ren     (/* unused */),
+	.ch1_write_addr_i      (write_addr[32 +: 32]),
+	.ch1_write_addr_o      (write_addr_wdata[32 +: 32]),
+	.ch1_write_addr_wen    (write_addr_wen[1]),
+	.ch1_write_addr_ren    (/* unused */),
+	.ch1_count_i           (count[32 +: 32]),
+	.ch1_count_o           (count_wdata[32 +: 32]),
+	.ch1_count_wen         (count_wen[1]),
+	.ch1_count_ren         (/* unused */),
+	.ch1_ctrl_en_o         (ctrl_en[1]),
+	.ch1_ctrl_size_o       (ctrl_size[2 +: 2]),
+	.ch1_ctrl_incr_read_o  (ctrl_incr_read[1]),
+	.ch1_ctrl_incr_write_o (ctrl_incr_write[1]),
+	.ch1_ctrl_pace_o       (ctrl_pace[1]),
+	.ch1_ctrl_irq_en_o     (ctrl_irq_en[1]),
+	.ch1_ctrl_read_zero_o  (ctrl_read_zero[1]),
+	.ch1_ctrl_busy_i       (ctrl_busy[1]),
+	.ch1_ctrl_err_o        (ctrl_err[1]),
+	.ch1_ctrl_err_set      (ctrl_err_set[1]),
+	.ch1_pace_addr_o       (pace_addr[32 +: 32]),
+	.ch1_pace_mask_o       (pace_mask[32 +: 32]),
+	.ch1_pace_match_o      (pace_match[32 +: 32]),
+
+	.intr_o                (intr),
+	.intr_set              (intr_set)
+);
+
+// Pacing back-off: backoff_ctr counts down the cycles until the channel may
+// be served again, and backoff_log2 is the length of the next back-off.
+localparam BACKOFF_LOG2_MAX = 6;
+
+reg  [3*N_CH-1:0]  backoff_log2;
+reg  [7*N_CH-1:0]  backoff_ctr;
+wire [N_CH-1:0]    ch_ready;
+
+genvar g;
+generate
+for (g = 0; g < N_CH; g = g + 1) begin: busy_loop
+	assign ctrl_busy[g] = ctrl_en[g] && |count[g * 32 +: 32];
+	assign ch_ready[g] = ctrl_busy[g] && ~|backoff_ctr[g * 7 +: 7];
+end
+endgenerate
+
+assign irq = |(intr & ctrl_irq_en);
+
+// ----------------------------------------------------------------------------
+// Transfer state machine
+
+localparam S_IDLE    = 3'd0;
+localparam S_PACE_A  = 3'd1;
+localparam S_PACE_D  = 3'd2;
+localparam S_READ_A  = 3'd3;
+localparam S_READ_D  = 3'd4;
+localparam S_WRITE_A = 3'd5;
+localparam S_WRITE_D = 3'd6;
+
+reg  [2:0]  state;
+reg         ch;      // Channel currently being served
+reg  [31:0] data;
+
+// Round-robin: the other channel gets priority after each turn
+wire next_ch = ch_ready[!ch] ? !ch : ch;
+
+wire [1:0]  cur_size  = ctrl_size[ch * 2 +: 2];
+wire [31:0] cur_raddr = read_addr[ch * 32 +: 32];
+wire [31:0] cur_waddr = write_addr[ch * 32 +: 32];
+wire [31:0] cur_incr  = 32'h1 << cur_size;
+
+// Read data is replicated across all byte lanes, so it's in the right lane
+// for the write, whatever the write address alignment. This also suits APB
+// peripherals, which always see the full bus width.
+wire [31:0] rdata_shifted = ahblm_hrdata >> {cur_raddr[1:0], 3'h0};
+wire [31:0] rdata_repl =
+	cur_size == 2'd0 ? {4{rdata_shifted[7:0]}} :
+	cur_size == 2'd1 ? {2{rdata_shifted[15:0]}} : ahblm_hrdata;
+
+wire pace_ok = (ahblm_hrdata & pace_mask[ch * 32 +: 32]) == pace_match[ch * 32 +: 32];
+wire pace_done = state == S_PACE_D && ahblm_hready && !ahblm_hresp;
+
+wire [31:0] aphase_addr =
+	state == S_PACE_A  ? pace_addr[ch * 32 +: 32] :
+	state == S_WRITE_A ? cur_waddr : cur_raddr;
+
+wire aphase = state == S_PACE_A || state == S_READ_A || state == S_WRITE_A;
+wire dphase = state == S_PACE_D || state == S_READ_D || state == S_WRITE_D;
+
+// Bit 27 is clear for TCM addresses, as decoded by the processor splitters.
+// Checked before issuing, so the transfer never reaches the bus.
+wire addr_err = aphase && !aphase_addr[27];
+wire bus_err = (dphase && ahblm_hready && ahblm_hresp) || addr_err;
+
+always @ (posedge clk or negedge rst_n) begin
+	if (!rst_n) begin
+		state <= S_IDLE;
+		ch <= 1'b0;
+		data <= 32'h0;
+	end else if (bus_err) begin
+		state <= S_IDLE;
+	end else case (state)
+	// READ_ZERO channels skip the read, and write zero
+	S_IDLE: if (|ch_ready) begin
+		ch <= next_ch;
+		data <= 32'h0;
+		state <= ctrl_pace[next_ch] ? S_PACE_A :
+			ctrl_read_zero[next_ch] ? S_WRITE_A : S_READ_A;
+	end
+	S_PACE_A:  if (ahblm_hready) state <= S_PACE_D;
+	S_PACE_D:  if (ahblm_hready) state <= !pace_ok ? S_IDLE :
+		ctrl_read_zero[ch] ? S_WRITE_A : S_READ_A;
+	S_READ_A:  if (ahblm_hready) state <= S_READ_D;
+	S_READ_D:  if (ahblm_hready) begin
+		state <= S_WRITE_A;
+		data <= rdata_repl;
+	end
+	S_WRITE_A: if (ahblm_hready) state <= S_WRITE_D;
+	S_WRITE_D: if (ahblm_hready) state <= S_IDLE;
+	default: state <= S_IDLE;
+	endcase
+end
+
+// Channel address and count registers: updated at the end of each transfer,
+// or written by software (which wins).
+
+wire xfer_done = state == S_WRITE_D && ahblm_hready && !ahblm_hresp;
+
+integer i;
+always @ (posedge clk or negedge rst_n) begin
+	if (!rst_n) begin
+		read_addr <= {32*N_CH{1'b0}};
+		write_addr <= {32*N_CH{1'b0}};
+		count <= {32*N_CH{1'b0}};
+	end else begin
+		if (xfer_done) begin
+			if (ctrl_incr_read[ch])
+				read_addr[ch * 32 +: 32] <= cur_raddr + cur_incr;
+			if (ctrl_incr_write[ch])
+				write_addr[ch * 32 +: 32] <= cur_waddr + cur_incr;
+			count[ch * 32 +: 32] <= count[ch * 32 +: 32] - 32'h1;
+		end
+		if (bus_err) begin
+			count[ch * 32 +: 32] <= 32'h0;
+		end
+		for (i = 0; i < N_CH; i = i + 1) begin
+			if (read_addr_wen[i])
+				read_addr[i * 32 +: 32] <= read_addr_wdata[i * 32 +: 32];
+			if (write_addr_wen[i])
+				write_addr[i * 32 +: 32] <= write_addr_wdata[i * 32 +: 32];
+			if (count_wen[i])
+				count[i * 32 +: 32] <= count_wdata[i * 32 +: 32];
+		end
+	end
+end
+
+always @ (*) begin
+	intr_set = {N_CH{1'b0}};
+	ctrl_err_set = {N_CH{1'b0}};
+	if (xfer_done && count[ch * 32 +: 32] == 32'h1)
+		intr_set[ch] = 1'b1;
+	if (bus_err)
+		ctrl_err_set[ch] = 1'b1;
+end
+
+// Pacing back-off counters
+
+always @ (posedge clk or negedge rst_n) begin
+	if (!rst_n) begin
+		backoff_log2 <= {3*N_CH{1'b0}};
+		backoff_ctr <= {7*N_CH{1'b0}};
+	end else begin
+		for (i = 0; i < N_CH; i = i + 1) begin
+			if (|backoff_ctr[i * 7 +: 7])
+				backoff_ctr[i * 7 +: 7] <= backoff_ctr[i * 7 +: 7] - 7'h1;
+			if (!ctrl_busy[i]) begin
+				backoff_log2[i * 3 +: 3] <= 3'h0;
+				backoff_ctr[i * 7 +: 7] <= 7'h0;
+			end
+		end
+		if (pace_done && pace_ok) begin
+			backoff_log2[ch * 3 +: 3] <= 3'h0;
+		end else if (pace_done) begin
+			backoff_ctr[ch * 7 +: 7] <= 7'h1 << backoff_log2[ch * 3 +: 3];
+			if (backoff_log2[ch * 3 +: 3] != BACKOFF_LOG2_MAX)
+				backoff_log2[ch * 3 +: 3] <= backoff_log2[ch * 3 +: 3] + 3'h1;
+		end
+	end
+end
+
+// ----------------------------------------------------------------------------
+// Bus interface
+
+assign ahblm_hburst = 3'h0;
+assign ahblm_hprot = 4'b0011; // Privileged data access
+assign ahblm_hmastlock = 1'b0;
+
+always @ (*) begin
+	ahblm_htrans = aphase && !addr_err ? 2'b10 : 2'b00;
+	ahblm_haddr = aphase_addr;
+	ahblm_hwrite = state == S_WRITE_A;
+	ahblm_hsize = state == S_PACE_A ? 3'd2 : {1'b0, cur_size};
+end
+
+assign ahblm_hwdata = data;
+
+endmodule
+
+`ifndef YOSYS
+`default_nettype wire
+`endif
@@ -0,0 +1,372 @@
+/*******************************************************************************
+*                       REGISTER BLOCK, WRITTEN BY HAND                        *
+*        Laid out like regblock output, but not generated by regblock.         *
+*             Keep in step with dma_regs.yml when editing either.              *
+*******************************************************************************/
+
+// Block name           : dma
+// Bus type             : apb
+// Bus data width       : 32
+// Bus address width    : 16
+
+module dma_regs (
+	input wire clk,
+	input wire rst_n,
+	
+	// APB Port
+	input wire apbs_psel,
+	input wire apbs_penable,
+	input wire apbs_pwrite,
+	input wire [15:0] apbs_paddr,
+	input wire [31:0] apbs_pwdata,
+	output wire [31:0] apbs_prdata,
+	output wire apbs_pready,
+	output wire apbs_pslverr,
+	
+	// Register interfaces
+	input wire [31:0] ch0_read_addr_i,
+	output reg [31:0] ch0_read_addr_o,
+	output reg ch0_read_addr_wen,
+	output reg ch0_read_addr_ren,
+	input wire [31:0] ch0_write_addr_i,
+	output reg [31:0] ch0_write_addr_o,
+	output reg ch0_write_addr_wen,
+	output reg ch0_write_addr_ren,
+	input wire [31:0] ch0_count_i,
+	output reg [31:0] ch0_count_o,
+	output reg ch0_count_wen,
+	output reg ch0_count_ren,
+	output reg ch0_ctrl_en_o,
+	output reg [1:0] ch0_ctrl_size_o,
+	output reg ch0_ctrl_incr_read_o,
+	output reg ch0_ctrl_incr_write_o,
+	output reg ch0_ctrl_pace_o,
+	output reg ch0_ctrl_irq_en_o,
+	output reg ch0_ctrl_read_zero_o,
+	input wire ch0_ctrl_busy_i,
+	output reg ch0_ctrl_err_o,
+	input wire ch0_ctrl_err_set,
+	output reg [31:0] ch0_pace_addr_o,
+	output reg [31:0] ch0_pace_mask_o,
+	output reg [31:0] ch0_pace_match_o,
+	input wire [31:0] ch1_read_addr_i,
+	output reg [31:0] ch1_read_addr_o,
+	output reg ch1_read_addr_wen,
+	output reg ch1_read_addr_ren,
+	input wire [31:0] ch1_write_addr_i,
+	output reg [31:0] ch1_write_addr_o,
+	output reg ch1_write_addr_wen,
+	output reg ch1_write_addr_ren,
+	input wire [31:0] ch1_count_i,
+	output reg [31:0] ch1_count_o,
+	output reg ch1_count_wen,
+	output reg ch1_count_ren,
+	output reg ch1_ctrl_en_o,
+	output reg [1:0] ch1_ctrl_size_o,
+	output reg ch1_ctrl_incr_read_o,
+	output reg ch1_ctrl_incr_write_o,
+	output reg ch1_ctrl_pace_o,
+	output reg ch1_ctrl_irq_en_o,
+	output reg ch1_ctrl_read_zero_o,
+	input wire ch1_ctrl_busy_i,
+	output reg ch1_ctrl_err_o,
+	input wire ch1_ctrl_err_set,
+	output reg [31:0] ch1_pace_addr_o,
+	output reg [31:0] ch1_pace_mask_o,
+	output reg [31:0] ch1_pace_match_o,
+	output reg [1:0] intr_o,
+	input wire [1:0] intr_set
+);
+
+// APB adapter
+wire [31:0] wdata = apbs_pwdata;
+reg [31:0] rdata;
+wire wen = apbs_psel && apbs_penable && apbs_pwrite;
+wire ren = apbs_psel && apbs_penable && !apbs_pwrite;
+wire [15:0] addr = apbs_paddr & 16'h3c;
+assign apbs_prdata = rdata;
+assign apbs_pready = 1'b1;
+assign apbs_pslverr = 1'b0;
+
+localparam ADDR_CH0_READ_ADDR = 0;
+localparam ADDR_CH0_WRITE_ADDR = 4;
+localparam ADDR_CH0_COUNT = 8;
+localparam ADDR_CH0_CTRL = 12;
+localparam ADDR_CH0_PACE_ADDR = 16;
+localparam ADDR_CH0_PACE_MASK = 20;
+localparam ADDR_CH0_PACE_MATCH = 24;
+localparam ADDR_CH1_READ_ADDR = 28;
+localparam ADDR_CH1_WRITE_ADDR = 32;
+localparam ADDR_CH1_COUNT = 36;
+localparam ADDR_CH1_CTRL = 40;
+localparam ADDR_CH1_PACE_ADDR = 44;
+localparam ADDR_CH1_PACE_MASK = 48;
+localparam ADDR_CH1_PACE_MATCH = 52;
+localparam ADDR_INTR = 56;
+
+wire __ch0_read_addr_wen = wen && addr == ADDR_CH0_READ_ADDR;
+wire __ch0_read_addr_ren = ren && addr == ADDR_CH0_READ_ADDR;
+wire __ch0_write_addr_wen = wen && addr == ADDR_CH0_WRITE_ADDR;
+wire __ch0_write_addr_ren = ren && addr == ADDR_CH0_WRITE_ADDR;
+wire __ch0_count_wen = wen && addr == ADDR_CH0_COUNT;
+wire __ch0_count_ren = ren && addr == ADDR_CH0_COUNT;
+wire __ch0_ctrl_wen = wen && addr == ADDR_CH0_CTRL;
+wire __ch0_ctrl_ren = ren && addr == ADDR_CH0_CTRL;
+wire __ch0_pace_addr_wen = wen && addr == ADDR_CH0_PACE_ADDR;
+wire __ch0_pace_addr_ren = ren && addr == ADDR_CH0_PACE_ADDR;
+wire __ch0_pace_mask_wen = wen && addr == ADDR_CH0_PACE_MASK;
+wire __ch0_pace_mask_ren = ren && addr == ADDR_CH0_PACE_MASK;
+wire __ch0_pace_match_wen = wen && addr == ADDR_CH0_PACE_MATCH;
+wire __ch0_pace_match_ren = ren && addr == ADDR_CH0_PACE_MATCH;
+wire __ch1_read_addr_wen = wen && addr == ADDR_CH1_READ_ADDR;
+wire __ch1_read_addr_ren = ren && addr == ADDR_CH1_READ_ADDR;
+wire __ch1_write_addr_wen = wen && addr == ADDR_CH1_WRITE_ADDR;
+wire __ch1_write_addr_ren = ren && addr == ADDR_CH1_WRITE_ADDR;
+wire __ch1_count_wen = wen && addr == ADDR_CH1_COUNT;
+wire __ch1_count_ren = ren && addr == ADDR_CH1_COUNT;
+wire __ch1_ctrl_wen = wen && addr == ADDR_CH1_CTRL;
+wire __ch1_ctrl_ren = ren && addr == ADDR_CH1_CTRL;
+wire __ch1_pace_addr_wen = wen && addr == ADDR_CH1_PACE_ADDR;
+wire __ch1_pace_addr_ren = ren && addr == ADDR_CH1_PACE_ADDR;
+wire __ch1_pace_mask_wen = wen && addr == ADDR_CH1_PACE_MASK;
+wire __ch1_pace_mask_ren = ren && addr == ADDR_CH1_PACE_MASK;
+wire __ch1_pace_match_wen = wen && addr == ADDR_CH1_PACE_MATCH;
+wire __ch1_pace_match_ren = ren && addr == ADDR_CH1_PACE_MATCH;
+wire __intr_wen = wen && addr == ADDR_INTR;
+wire __intr_ren = ren && addr == ADDR_INTR;
+
+wire [31:0] ch0_read_addr_wdata = wdata[31:0];
+wire [31:0] ch0_read_addr_rdata;
+wire [31:0] __ch0_read_addr_rdata = {ch0_read_addr_rdata};
+assign ch0_read_addr_rdata = ch0_read_addr_i;
+
+wire [31:0] ch0_write_addr_wdata = wdata[31:0];
+wire [31:0] ch0_write_addr_rdata;
+wire [31:0] __ch0_write_addr_rdata = {ch0_write_addr_rdata};
+assign ch0_write_addr_rdata = ch0_write_addr_i;
+
+wire [31:0] ch0_count_wdata = wdata[31:0];
+wire [31:0] ch0_count_rdata;
+wire [31:0] __ch0_count_rdata = {ch0_count_rdata};
+assign ch0_count_rdata = ch0_count_i;
+
+wire ch0_ctrl_en_wdata = wdata[0];
+wire ch0_ctrl_en_rdata;
+wire [1:0] ch0_ctrl_size_wdata = wdata[2:1];
+wire [1:0] ch0_ctrl_size_rdata;
+wire ch0_ctrl_incr_read_wdata = wdata[3];
+wire ch0_ctrl_incr_read_rdata;
+wire ch0_ctrl_incr_write_wdata = wdata[4];
+wire ch0_ctrl_incr_write_rdata;
+wire ch0_ctrl_pace_wdata = wdata[5];
+wire ch0_ctrl_pace_rdata;
+wire ch0_ctrl_irq_en_wdata = wdata[6];
+wire ch0_ctrl_irq_en_rdata;
+wire ch0_ctrl_read_zero_wdata = wdata[7];
+wire ch0_ctrl_read_zero_rdata;
+wire ch0_ctrl_busy_wdata = wdata[8];
+wire ch0_ctrl_busy_rdata;
+wire ch0_ctrl_err_wdata = wdata[9];
+wire ch0_ctrl_err_rdata;
+wire [31:0] __ch0_ctrl_rdata = {22'h0, ch0_ctrl_err_rdata, ch0_ctrl_busy_rdata, ch0_ctrl_read_zero_rdata, ch0_ctrl_irq_en_rdata, ch0_ctrl_pace_rdata, ch0_ctrl_incr_write_rdata, ch0_ctrl_incr_read_rdata, ch0_ctrl_size_rdata, ch0_ctrl_en_rdata};
+assign ch0_ctrl_en_rdata = ch0_ctrl_en_o;
+assign ch0_ctrl_size_rdata = ch0_ctrl_size_o;
+assign ch0_ctrl_incr_read_rdata = ch0_ctrl_incr_read_o;
+assign ch0_ctrl_incr_write_rdata = ch0_ctrl_incr_write_o;
+assign ch0_ctrl_pace_rdata = ch0_ctrl_pace_o;
+assign ch0_ctrl_irq_en_rdata = ch0_ctrl_irq_en_o;
+assign ch0_ctrl_read_zero_rdata = ch0_ctrl_read_zero_o;
+assign ch0_ctrl_busy_rdata = ch0_ctrl_busy_i;
+assign ch0_ctrl_err_rdata = ch0_ctrl_err_o;
+
+wire [31:0] ch0_pace_addr_wdata = wdata[31:0];
+wire [31:0] ch0_pace_addr_rdata;
+wire [31:0] __ch0_pace_addr_rdata = {ch0_pace_addr_rdata};
+assign ch0_pace_addr_rdata = ch0_pace_addr_o;
+
+wire [31:0] ch0_pace_mask_wdata = wdata[31:0];
+wire [31:0] ch0_pace_mask_rdata;
+wire [31:0] __ch0_pace_mask_rdata = {ch0_pace_mask_rdata};
+assign ch0_pace_mask_rdata = ch0_pace_mask_o;
+
+wire [31:0] ch0_pace_match_wdata = wdata[31:0];
+wire [31:0] ch0_pace_match_rdata;
+wire [31:0] __ch0_pace_match_rdata = {ch0_pace_match_rdata};
+assign ch0_pace_match_rdata = ch0_pace_match_o;
+
+wire [31:0] ch1_read_addr_wdata = wdata[31:0];
+wire [31:0] ch1_read_addr_rdata;
+wire [31:0] __ch1_read_addr_rdata = {ch1_read_addr_rdata};
+assign ch1_read_addr_rdata = ch1_read_addr_i;
+
+wire [31:0] ch1_write_addr_wdata = wdata[31:0];
+wire [31:0] ch1_write_addr_rdata;
+wire [31:0] __ch1_write_addr_rdata = {ch1_write_addr_rdata};
+assign ch1_write_addr_rdata = ch1_write_addr_i;
+
+wire [31:0] ch1_count_wdata = wdata[31:0];
+wire [31:0] ch1_count_rdata;
+wire [31:0] __ch1_count_rdata = {ch1_count_rdata};
+assign ch1_count_rdata = ch1_count_i;
+
+wire ch1_ctrl_en_wdata = wdata[0];
+wire ch1_ctrl_en_rdata;
+wire [1:0] ch1_ctrl_size_wdata = wdata[2:1];
+wire [1:0] ch1_ctrl_size_rdata;
+wire ch1_ctrl_incr_read_wdata = wdata[3];
+wire ch1_ctrl_incr_read_rdata;
+wire ch1_ctrl_incr_write_wdata = wdata[4];
+wire ch1_ctrl_incr_write_rdata;
+wire ch1_ctrl_pace_wdata = wdata[5];
+wire ch1_ctrl_pace_rdata;
+wire ch1_ctrl_irq_en_wdata = wdata[6];
+wire ch1_ctrl_irq_en_rdata;
+wire ch1_ctrl_read_zero_wdata = wdata[7];
+wire ch1_ctrl_read_zero_rdata;
+wire ch1_ctrl_busy_wdata = wdata[8];
+wire ch1_ctrl_busy_rdata;
+wire ch1_ctrl_err_wdata = wdata[9];
+wire ch1_ctrl_err_rdata;
+wire [31:0] __ch1_ctrl_rdata = {22'h0, ch1_ctrl_err_rdata, ch1_ctrl_busy_rdata, ch1_ctrl_read_zero_rdata, ch1_ctrl_irq_en_rdata, ch1_ctrl_pace_rdata, ch1_ctrl_incr_write_rdata, ch1_ctrl_incr_read_rdata, ch1_ctrl_size_rdata, ch1_ctrl_en_rdata};
+assign ch1_ctrl_en_rdata = ch1_ctrl_en_o;
+assign ch1_ctrl_size_rdata = ch1_ctrl_size_o;
+assign ch1_ctrl_incr_read_rdata = ch1_ctrl_incr_read_o;
+assign ch1_ctrl_incr_write_rdata = ch1_ctrl_incr_write_o;
+assign ch1_ctrl_pace_rdata = ch1_ctrl_pace_o;
+assign ch1_ctrl_irq_en_rdata = ch1_ctrl_irq_en_o;
+assign ch1_ctrl_read_zero_rdata = ch1_ctrl_read_zero_o;
+assign ch1_ctrl_busy_rdata = ch1_ctrl_busy_i;
+assign ch1_ctrl_err_rdata = ch1_ctrl_err_o;
+
+wire [31:0] ch1_pace_addr_wdata = wdata[31:0];
+wire [31:0] ch1_pace_addr_rdata;
+wire [31:0] __ch1_pace_addr_rdata = {ch1_pace_addr_rdata};
+assign ch1_pace_addr_rdata = ch1_pace_addr_o;
+
+wire [31:0] ch1_pace_mask_wdata = wdata[31:0];
+wire [31:0] ch1_pace_mask_rdata;
+wire [31:0] __ch1_pace_mask_rdata = {ch1_pace_mask_rdata};
+assign ch1_pace_mask_rdata = ch1_pace_mask_o;
+
+wire [31:0] ch1_pace_match_wdata = wdata[31:0];
+wire [31:0] ch1_pace_match_rdata;
+wire [31:0] __ch1_pace_match_rdata = {ch1_pace_match_rdata};
+assign ch1_pace_match_rdata = ch1_pace_match_o;
+
+wire [1:0] intr_wdata = wdata[1:0];
+wire [1:0] intr_rdata;
+wire [31:0] __intr_rdata = {30'h0, intr_rdata};
+assign intr_rdata = intr_o;
+
+always @ (*) begin
+	case (addr)
+		ADDR_CH0_READ_ADDR: rdata = __ch0_read_addr_rdata;
+		ADDR_CH0_WRITE_ADDR: rdata = __ch0_write_addr_rdata;
+		ADDR_CH0_COUNT: rdata = __ch0_count_rdata;
+		ADDR_CH0_CTRL: rdata = __ch0_ctrl_rdata;
+		ADDR_CH0_PACE_ADDR: rdata = __ch0_pace_addr_rdata;
+		ADDR_CH0_PACE_MASK: rdata = __ch0_pace_mask_rdata;
+		ADDR_CH0_PACE_MATCH: rdata = __ch0_pace_match_rdata;
+		ADDR_CH1_READ_ADDR: rdata = __ch1_read_addr_rdata;
+		ADDR_CH1_WRITE_ADDR: rdata = __ch1_write_addr_rdata;
+		ADDR_CH1_COUNT: rdata = __ch1_count_rdata;
+		ADDR_CH1_CTRL: rdata = __ch1_ctrl_rdata;
+		ADDR_CH1_PACE_ADDR: rdata = __ch1_pace_addr_rdata;
+		ADDR_CH1_PACE_MASK: rdata = __ch1_pace_mask_rdata;
+		ADDR_CH1_PACE_MATCH: rdata = __ch1_pace_match_rdata;
+		ADDR_INTR: rdata = __intr_rdata;
+		default: rdata = 32'h0;
+	endcase
+	ch0_read_addr_wen = __ch0_read_addr_wen;
+	ch0_read_addr_o = ch0_read_addr_wdata;
+	ch0_read_addr_ren = __ch0_read_addr_ren;
+	ch0_write_addr_wen = __ch0_write_addr_wen;
+	ch0_write_addr_o = ch0_write_addr_wdata;
+	ch0_write_addr_ren = __ch0_write_addr_ren;
+	ch0_count_wen = __ch0_count_wen;
+	ch0_count_o = ch0_count_wdata;
+	ch0_count_ren = __ch0_count_ren;
+	ch1_read_addr_wen = __ch1_read_addr_wen;
+	ch1_read_addr_o = ch1_read_addr_wdata;
+	ch1_read_addr_ren = __ch1_read_addr_ren;
+	ch1_write_addr_wen = __ch1_write_addr_wen;
+	ch1_write_addr_o = ch1_write_addr_wdata;
+	ch1_write_addr_ren = __ch1_write_addr_ren;
+	ch1_count_wen = __ch1_count_wen;
+	ch1_count_o = ch1_count_wdata;
+	ch1_count_ren = __ch1_count_ren;
+end
+
+always @ (posedge clk or negedge rst_n) begin
+	if (!rst_n) begin
+		ch0_ctrl_en_o <= 1'h0;
+		ch0_ctrl_size_o <= 2'h0;
+		ch0_ctrl_incr_read_o <= 1'h0;
+		ch0_ctrl_incr_write_o <= 1'h0;
+		ch0_ctrl_pace_o <= 1'h0;
+		ch0_ctrl_irq_en_o <= 1'h0;
+		ch0_ctrl_read_zero_o <= 1'h0;
+		ch0_ctrl_err_o <= 1'h0;
+		ch0_pace_addr_o <= 32'h0;
+		ch0_pace_mask_o <= 32'h0;
+		ch0_pace_match_o <= 32'h0;
+		ch1_ctrl_en_o <= 1'h0;
+		ch1_ctrl_size_o <= 2'h0;
+		ch1_ctrl_incr_read_o <= 1'h0;
+		ch1_ctrl_incr_write_o <= 1'h0;
+		ch1_ctrl_pace_o <= 1'h0;
+		ch1_ctrl_irq_en_o <= 1'h0;
+		ch1_ctrl_read_zero_o <= 1'h0;
+		ch1_ctrl_err_o <= 1'h0;
+		ch1_pace_addr_o <= 32'h0;
+		ch1_pace_mask_o <= 32'h0;
+		ch1_pace_match_o <= 32'h0;
+		intr_o <= 2'h0;
+	end else begin
+		if (__ch0_ctrl_wen)
+			ch0_ctrl_en_o <= ch0_ctrl_en_wdata;
+		if (__ch0_ctrl_wen)
+			ch0_ctrl_size_o <= ch0_ctrl_size_wdata;
+		if (__ch0_ctrl_wen)
+			ch0_ctrl_incr_read_o <= ch0_ctrl_incr_read_wdata;
+		if (__ch0_ctrl_wen)
+			ch0_ctrl_incr_write_o <= ch0_ctrl_incr_write_wdata;
+		if (__ch0_ctrl_wen)
+			ch0_ctrl_pace_o <= ch0_ctrl_pace_wdata;
+		if (__ch0_ctrl_wen)
+			ch0_ctrl_irq_en_o <= ch0_ctrl_irq_en_wdata;
+		if (__ch0_ctrl_wen)
+			ch0_ctrl_read_zero_o <= ch0_ctrl_read_zero_wdata;
+		ch0_ctrl_err_o <= (ch0_ctrl_err_o & ~({1{__ch0_ctrl_wen}} & ch0_ctrl_err_wdata)) | ch0_ctrl_err_set;
+		if (__ch0_pace_addr_wen)
+			ch0_pace_addr_o <= ch0_pace_addr_wdata;
+		if (__ch0_pace_mask_wen)
+			ch0_pace_mask_o <= ch0_pace_mask_wdata;
+		if (__ch0_pace_match_wen)
+			ch0_pace_match_o <= ch0_pace_match_wdata;
+		if (__ch1_ctrl_wen)
+			ch1_ctrl_en_o <= ch1_ctrl_en_wdata;
+		if (__ch1_ctrl_wen)
+			ch1_ctrl_size_o <= ch1_ctrl_size_wdata;
+		if (__ch1_ctrl_wen)
+			ch1_ctrl_incr_read_o <= ch1_ctrl_incr_read_wdata;
+		if (__ch1_ctrl_wen)
+			ch1_ctrl_incr_write_o <= ch1_ctrl_incr_write_wdata;
+		if (__ch1_ctrl_wen)
+			ch1_ctrl_pace_o <= ch1_ctrl_pace_wdata;
+		if (__ch1_ctrl_wen)
+			ch1_ctrl_irq_en_o <= ch1_ctrl_irq_en_wdata;
+		if (__ch1_ctrl_wen)
+			ch1_ctrl_read_zero_o <= ch1_ctrl_read_zero_wdata;
+		ch1_ctrl_err_o <= (ch1_ctrl_err_o & ~({1{__ch1_ctrl_wen}} & ch1_ctrl_err_wdata)) | ch1_ctrl_err_set;
+		if (__ch1_pace_addr_wen)
+			ch1_pace_addr_o <= ch1_pace_addr_wdata;
+		if (__ch1_pace_mask_wen)
+			ch1_pace_mask_o <= ch1_pace_mask_wdata;
+		if (__ch1_pace_match_wen)
+			ch1_pace_match_o <= ch1_pace_match_wdata;
+		intr_o <= (intr_o & ~({2{__intr_wen}} & intr_wdata)) | intr_set;
+	end
+end
+
+endmodule
@@ -0,0 +1,2 @@
+file perf_counters.v
+file perf_regs.v
@@ -0,0 +1,133 @@
+/*****************************************************************************\
+|                        Copyright (C) 2021 Luke Wren                         |
+|                     SPDX-License-Identifier: Apache-2.0                     |
+\*****************************************************************************/
+
+// Four 64-bit event counters, each with its own event select. The SoC decides
+// what the events are: each bit of `events` is high for every cycle in which
+// that event occurs, and is counted once per cycle. The event map is listed
+// in soc.v, and in perf.h for software.
+
+`default_nettype none
+
+module perf_counters (
+	input  wire        clk,
+	input  wire        rst_n,
+
+	input  wire        apbs_psel,
+	input  wire        apbs_penable,
+	input  wire        apbs_pwrite,
+	input  wire [15:0] apbs_paddr,
+	input  wire [31:0] apbs_pwdata,
+	output wire [31:0] apbs_prdata,
+	output wire        apbs_pready,
+	output wire        apbs_pslverr,
+
+	input  wire [31:0] events
+);
+
+localparam N_COUNTERS = 4;
+
+wire [N_COUNTERS-1:0]    ctr_en;
+wire [5*N_COUNTERS-1:0]  ctr_sel;
+
+wire [64*N_COUNTERS-1:0] ctr_rdata;
+wire [64*N_COUNTERS-1:0] ctr_wdata;
+wire [2*N_COUNTERS-1:0]  ctr_wen;
+
+// Register the events once, so the event logic in the SoC doesn't need to
+// meet timing through the mux and the 64-bit adders.
+reg [31:0] events_reg;
+
+always @ (posedge clk or negedge rst_n) begin
+	if (!rst_n) begin
+		events_reg <= 32'h0;
+	end else begin
+		events_reg <= events;
+	end
+end
+
+perf_regs regs (
+	.clk          (clk),
+	.rst_n        (rst_n),
+
+	.apbs_psel    (apbs_psel),
+	.apbs_penable (apbs_penable),
+	.apbs_pwrite  (apbs_pwrite),
+	.apbs_paddr   (apbs_paddr),
+	.apbs_pwdata  (apbs_pwdata),
+	.apbs_prdata  (apbs_prdata),
+	.apbs_pready  (apbs_pready),
+	.apbs_pslverr (apbs_pslverr),
+
+	.ctrl_o       (ctr_en),
+	.sel0_o       (ctr_sel[0 * 5 +: 5]),
+	.sel1_o       (ctr_sel[1 * 5 +: 5]),
+	.sel2_o       (ctr_sel[2 * 5 +: 5]),
+	.sel3_o       (ctr_sel[3 * 5 +: 5]),
+
+	.ctr0_i       (ctr_rdata[0 * 64 +: 32]),
+	.ctr0_o       (ctr_wdata[0 * 64 +: 32]),
+	.ctr0_wen     (ctr_wen[0 * 2]),
+	.ctr0_ren     (/* unused */),
+	.ctr0h_i      (ctr_rdata[0 * 64 + 32 +: 32]),
+	.ctr0h_o      (ctr_wdata[0 * 64 + 32 +: 32]),
+	.ctr0h_wen    (ctr_wen[0 * 2 + 1]),
+	.ctr0h_ren    (/* unused */),
+	.ctr1_i       (ctr_rdata[1 * 64 +: 32]),
+	.ctr1_o       (ctr_wdata[1 * 64 +: 32]),
+	.ctr1_wen     (ctr_wen[1 * 2]),
+	.ctr1_ren     (/* unused */),
+	.ctr1h_i      (ctr_rdata[1 * 64 + 32 +: 32]),
+	.ctr1h_o      (ctr_wdata[1 * 64 + 32 +: 32]),
+	.ctr1h_wen    (ctr_wen[1 * 2 + 1]),
+	.ctr1h_ren    (/* unused */),
+	.ctr2_i       (ctr_rdata[2 * 64 +: 32]),
+	.ctr2_o       (ctr_wdata[2 * 64 +: 32]),
+	.ctr2_wen     (ctr_wen[2 * 2]),
+	.ctr2_ren     (/* unused */),
+	.ctr2h_i      (ctr_rdata[2 * 64 + 32 +: 32]),
+	.ctr2h_o      (ctr_wdata[2 * 64 + 32 +: 32]),
+	.ctr2h_wen    (ctr_wen[2 * 2 + 1]),
+	.ctr2h_ren    (/* unused */),
+	.ctr3_i       (ctr_rdata[3 * 64 +: 32]),
+	.ctr3_o       (ctr_wdata[3 * 64 +: 32]),
+	.ctr3_wen     (ctr_wen[3 * 2]),
+	.ctr3_ren     (/* unused */),
+	.ctr3h_i      (ctr_rdata[3 * 64 + 32 +: 32]),
+	.ctr3h_o      (ctr_wdata[3 * 64 + 32 +: 32]),
+	.ctr3h_wen    (ctr_wen[3 * 2 + 1]),
+	.ctr3h_ren    (/* unused */)
+);
+
+genvar i;
+generate
+for (i = 0; i < N_COUNTERS; i = i + 1) begin: ctr_loop
+
+	wire count = ctr_en[i] && events_reg[ctr_sel[i * 5 +: 5]];
+	reg [63:0] ctr;
+
+	always @ (posedge clk or negedge rst_n) begin
+		if (!rst_n) begin
+			ctr <= 64'h0;
+		end else begin
+			if (count)
+				ctr <= ctr + 64'h1;
+
+			if (ctr_wen[i * 2 + 1])
+				ctr[63:32] <= ctr_wdata[i * 64 + 32 +: 32];
+			if (ctr_wen[i * 2])
+				ctr[31:0]  <= ctr_wdata[i * 64 +: 32];
+		end
+	end
+
+	assign ctr_rdata[i * 64 +: 64] = ctr;
+
+end
+endgenerate
+
+endmodule
+
+`ifndef YOSYS
+`default_nettype wire
+`endif
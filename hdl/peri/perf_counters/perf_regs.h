@@ -0,0 +1,172 @@
+/*******************************************************************************
+*                       REGISTER BLOCK, WRITTEN BY HAND                        *
+*        Laid out like regblock output, but not generated by regblock.         *
+*             Keep in step with perf_regs.yml when editing either.             *
+*******************************************************************************/
+
+#ifndef _PERF_REGS_H_
+#define _PERF_REGS_H_
+
+// Block name           : perf
+// Bus type             : apb
+// Bus data width       : 32
+// Bus address width    : 16
+
+#define PERF_CTRL_OFFS 0
+#define PERF_SEL0_OFFS 4
+#define PERF_SEL1_OFFS 8
+#define PERF_SEL2_OFFS 12
+#define PERF_SEL3_OFFS 16
+#define PERF_CTR0_OFFS 20
+#define PERF_CTR0H_OFFS 24
+#define PERF_CTR1_OFFS 28
+#define PERF_CTR1H_OFFS 32
+#define PERF_CTR2_OFFS 36
+#define PERF_CTR2H_OFFS 40
+#define PERF_CTR3_OFFS 44
+#define PERF_CTR3H_OFFS 48
+
+/*******************************************************************************
+*                                     CTRL                                     *
+*******************************************************************************/
+
+// Counter enables. Counter n counts its selected event only while bit n is set.
+
+// Field: CTRL  Access: RW
+#define PERF_CTRL_LSB  0
+#define PERF_CTRL_BITS 4
+#define PERF_CTRL_MASK 0xf
+
+/*******************************************************************************
+*                                     SEL0                                     *
+*******************************************************************************/
+
+// Event select for counter 0. See perf.h for the list of events.
+
+// Field: SEL0  Access: RW
+#define PERF_SEL0_LSB  0
+#define PERF_SEL0_BITS 5
+#define PERF_SEL0_MASK 0x1f
+
+/*******************************************************************************
+*                                     SEL1                                     *
+*******************************************************************************/
+
+// Event select for counter 1. See perf.h for the list of events.
+
+// Field: SEL1  Access: RW
+#define PERF_SEL1_LSB  0
+#define PERF_SEL1_BITS 5
+#define PERF_SEL1_MASK 0x1f
+
+/*******************************************************************************
+*                                     SEL2                                     *
+*******************************************************************************/
+
+// Event select for counter 2. See perf.h for the list of events.
+
+// Field: SEL2  Access: RW
+#define PERF_SEL2_LSB  0
+#define PERF_SEL2_BITS 5
+#define PERF_SEL2_MASK 0x1f
+
+/*******************************************************************************
+*                                     SEL3                                     *
+*******************************************************************************/
+
+// Event select for counter 3. See perf.h for the list of events.
+
+// Field: SEL3  Access: RW
+#define PERF_SEL3_LSB  0
+#define PERF_SEL3_BITS 5
+#define PERF_SEL3_MASK 0x1f
+
+/*******************************************************************************
+*                                     CTR0                                     *
+*******************************************************************************/
+
+// Read/write access to counter 0, low half
+
+// Field: CTR0  Access: RWF
+#define PERF_CTR0_LSB  0
+#define PERF_CTR0_BITS 32
+#define PERF_CTR0_MASK 0xffffffff
+
+/*******************************************************************************
+*                                    CTR0H                                     *
+*******************************************************************************/
+
+// Read/write access to counter 0, high half
+
+// Field: CTR0H  Access: RWF
+#define PERF_CTR0H_LSB  0
+#define PERF_CTR0H_BITS 32
+#define PERF_CTR0H_MASK 0xffffffff
+
+/*******************************************************************************
+*                                     CTR1                                     *
+*******************************************************************************/
+
+// Read/write access to counter 1, low half
+
+// Field: CTR1  Access: RWF
+#define PERF_CTR1_LSB  0
+#define PERF_CTR1_BITS 32
+#define PERF_CTR1_MASK 0xffffffff
+
+/*******************************************************************************
+*                                    CTR1H                                     *
+*******************************************************************************/
+
+// Read/write access to counter 1, high half
+
+// Field: CTR1H  Access: RWF
+#define PERF_CTR1H_LSB  0
+#define PERF_CTR1H_BITS 32
+#define PERF_CTR1H_MASK 0xffffffff
+
+/*******************************************************************************
+*                                     CTR2                                     *
+*******************************************************************************/
+
+// Read/write access to counter 2, low half
+
+// Field: CTR2  Access: RWF
+#define PERF_CTR2_LSB  0
+#define PERF_CTR2_BITS 32
+#define PERF_CTR2_MASK 0xffffffff
+
+/*******************************************************************************
+*                                    CTR2H                                     *
+*******************************************************************************/
+
+// Read/write access to counter 2, high half
+
+// Field: CTR2H  Access: RWF
+#define PERF_CTR2H_LSB  0
+#define PERF_CTR2H_BITS 32
+#define PERF_CTR2H_MASK 0xffffffff
+
+/*******************************************************************************
+*                                     CTR3                                     *
+*******************************************************************************/
+
+// Read/write access to counter 3, low half
+
+// Field: CTR3  Access: RWF
+#define PERF_CTR3_LSB  0
+#define PERF_CTR3_BITS 32
+#define PERF_CTR3_MASK 0xffffffff
+
+/*******************************************************************************
+*                                    CTR3H                                     *
+*******************************************************************************/
+
+// Read/write access to counter 3, high half
+
+// Field: CTR3H  Access: RWF
+#define PERF_CTR3H_LSB  0
+#define PERF_CTR3H_BITS 32
+#define PERF_CTR3H_MASK 0xffffffff
+
+#endif // _PERF_REGS_H_
@@ -0,0 +1,246 @@
+/*******************************************************************************
+*                       REGISTER BLOCK, WRITTEN BY HAND                        *
+*        Laid out like regblock output, but not generated by regblock.         *
+*             Keep in step with perf_regs.yml when editing either.             *
+*******************************************************************************/
+
+// Block name           : perf
+// Bus type             : apb
+// Bus data width       : 32
+// Bus address width    : 16
+
+module perf_regs (
+	input wire clk,
+	input wire rst_n,
+	
+	// APB Port
+	input wire apbs_psel,
+	input wire apbs_penable,
+	input wire apbs_pwrite,
+	input wire [15:0] apbs_paddr,
+	input wire [31:0] apbs_pwdata,
+	output wire [31:0] apbs_prdata,
+	output wire apbs_pready,
+	output wire apbs_pslverr,
+	
+	// Register interfaces
+	output reg [3:0] ctrl_o,
+	output reg [4:0] sel0_o,
+	output reg [4:0] sel1_o,
+	output reg [4:0] sel2_o,
+	output reg [4:0] sel3_o,
+	input wire [31:0] ctr0_i,
+	output reg [31:0] ctr0_o,
+	output reg ctr0_wen,
+	output reg ctr0_ren,
+	input wire [31:0] ctr0h_i,
+	output reg [31:0] ctr0h_o,
+	output reg ctr0h_wen,
+	output reg ctr0h_ren,
+	input wire [31:0] ctr1_i,
+	output reg [31:0] ctr1_o,
+	output reg ctr1_wen,
+	output reg ctr1_ren,
+	input wire [31:0] ctr1h_i,
+	output reg [31:0] ctr1h_o,
+	output reg ctr1h_wen,
+	output reg ctr1h_ren,
+	input wire [31:0] ctr2_i,
+	output reg [31:0] ctr2_o,
+	output reg ctr2_wen,
+	output reg ctr2_ren,
+	input wire [31:0] ctr2h_i,
+	output reg [31:0] ctr2h_o,
+	output reg ctr2h_wen,
+	output reg ctr2h_ren,
+	input wire [31:0] ctr3_i,
+	output reg [31:0] ctr3_o,
+	output reg ctr3_wen,
+	output reg ctr3_ren,
+	input wire [31:0] ctr3h_i,
+	output reg [31:0] ctr3h_o,
+	output reg ctr3h_wen,
+	output reg ctr3h_ren
+);
+
+// APB adapter
+wire [31:0] wdata = apbs_pwdata;
+reg [31:0] rdata;
+wire wen = apbs_psel && apbs_penable && apbs_pwrite;
+wire ren = apbs_psel && apbs_penable && !apbs_pwrite;
+wire [15:0] addr = apbs_paddr & 16'h3c;
+assign apbs_prdata = rdata;
+assign apbs_pready = 1'b1;
+assign apbs_pslverr = 1'b0;
+
+localparam ADDR_CTRL = 0;
+localparam ADDR_SEL0 = 4;
+localparam ADDR_SEL1 = 8;
+localparam ADDR_SEL2 = 12;
+localparam ADDR_SEL3 = 16;
+localparam ADDR_CTR0 = 20;
+localparam ADDR_CTR0H = 24;
+localparam ADDR_CTR1 = 28;
+localparam ADDR_CTR1H = 32;
+localparam ADDR_CTR2 = 36;
+localparam ADDR_CTR2H = 40;
+localparam ADDR_CTR3 = 44;
+localparam ADDR_CTR3H = 48;
+
+wire __ctrl_wen = wen && addr == ADDR_CTRL;
+wire __ctrl_ren = ren && addr == ADDR_CTRL;
+wire __sel0_wen = wen && addr == ADDR_SEL0;
+wire __sel0_ren = ren && addr == ADDR_SEL0;
+wire __sel1_wen = wen && addr == ADDR_SEL1;
+wire __sel1_ren = ren && addr == ADDR_SEL1;
+wire __sel2_wen = wen && addr == ADDR_SEL2;
+wire __sel2_ren = ren && addr == ADDR_SEL2;
+wire __sel3_wen = wen && addr == ADDR_SEL3;
+wire __sel3_ren = ren && addr == ADDR_SEL3;
+wire __ctr0_wen = wen && addr == ADDR_CTR0;
+wire __ctr0_ren = ren && addr == ADDR_CTR0;
+wire __ctr0h_wen = wen && addr == ADDR_CTR0H;
+wire __ctr0h_ren = ren && addr == ADDR_CTR0H;
+wire __ctr1_wen = wen && addr == ADDR_CTR1;
+wire __ctr1_ren = ren && addr == ADDR_CTR1;
+wire __ctr1h_wen = wen && addr == ADDR_CTR1H;
+wire __ctr1h_ren = ren && addr == ADDR_CTR1H;
+wire __ctr2_wen = wen && addr == ADDR_CTR2;
+wire __ctr2_ren = ren && addr == ADDR_CTR2;
+wire __ctr2h_wen = wen && addr == ADDR_CTR2H;
+wire __ctr2h_ren = ren && addr == ADDR_CTR2H;
+wire __ctr3_wen = wen && addr == ADDR_CTR3;
+wire __ctr3_ren = ren && addr == ADDR_CTR3;
+wire __ctr3h_wen = wen && addr == ADDR_CTR3H;
+wire __ctr3h_ren = ren && addr == ADDR_CTR3H;
+
+wire [3:0] ctrl_wdata = wdata[3:0];
+wire [3:0] ctrl_rdata;
+wire [31:0] __ctrl_rdata = {28'h0, ctrl_rdata};
+assign ctrl_rdata = ctrl_o;
+
+wire [4:0] sel0_wdata = wdata[4:0];
+wire [4:0] sel0_rdata;
+wire [31:0] __sel0_rdata = {27'h0, sel0_rdata};
+assign sel0_rdata = sel0_o;
+
+wire [4:0] sel1_wdata = wdata[4:0];
+wire [4:0] sel1_rdata;
+wire [31:0] __sel1_rdata = {27'h0, sel1_rdata};
+assign sel1_rdata = sel1_o;
+
+wire [4:0] sel2_wdata = wdata[4:0];
+wire [4:0] sel2_rdata;
+wire [31:0] __sel2_rdata = {27'h0, sel2_rdata};
+assign sel2_rdata = sel2_o;
+
+wire [4:0] sel3_wdata = wdata[4:0];
+wire [4:0] sel3_rdata;
+wire [31:0] __sel3_rdata = {27'h0, sel3_rdata};
+assign sel3_rdata = sel3_o;
+
+wire [31:0] ctr0_wdata = wdata[31:0];
+wire [31:0] ctr0_rdata;
+wire [31:0] __ctr0_rdata = {ctr0_rdata};
+assign ctr0_rdata = ctr0_i;
+
+wire [31:0] ctr0h_wdata = wdata[31:0];
+wire [31:0] ctr0h_rdata;
+wire [31:0] __ctr0h_rdata = {ctr0h_rdata};
+assign ctr0h_rdata = ctr0h_i;
+
+wire [31:0] ctr1_wdata = wdata[31:0];
+wire [31:0] ctr1_rdata;
+wire [31:0] __ctr1_rdata = {ctr1_rdata};
+assign ctr1_rdata = ctr1_i;
+
+wire [31:0] ctr1h_wdata = wdata[31:0];
+wire [31:0] ctr1h_rdata;
+wire [31:0] __ctr1h_rdata = {ctr1h_rdata};
+assign ctr1h_rdata = ctr1h_i;
+
+wire [31:0] ctr2_wdata = wdata[31:0];
+wire [31:0] ctr2_rdata;
+wire [31:0] __ctr2_rdata = {ctr2_rdata};
+assign ctr2_rdata = ctr2_i;
+
+wire [31:0] ctr2h_wdata = wdata[31:0];
+wire [31:0] ctr2h_rdata;
+wire [31:0] __ctr2h_rdata = {ctr2h_rdata};
+assign ctr2h_rdata = ctr2h_i;
+
+wire [31:0] ctr3_wdata = wdata[31:0];
+wire [31:0] ctr3_rdata;
+wire [31:0] __ctr3_rdata = {ctr3_rdata};
+assign ctr3_rdata = ctr3_i;
+
+wire [31:0] ctr3h_wdata = wdata[31:0];
+wire [31:0] ctr3h_rdata;
+wire [31:0] __ctr3h_rdata = {ctr3h_rdata};
+assign ctr3h_rdata = ctr3h_i;
+
+always @ (*) begin
+	case (addr)
+		ADDR_CTRL: rdata = __ctrl_rdata;
+		ADDR_SEL0: rdata = __sel0_rdata;
+		ADDR_SEL1: rdata = __sel1_rdata;
+		ADDR_SEL2: rdata = __sel2_rdata;
+		ADDR_SEL3: rdata = __sel3_rdata;
+		ADDR_CTR0: rdata = __ctr0_rdata;
+		ADDR_CTR0H: rdata = __ctr0h_rdata;
+		ADDR_CTR1: rdata = __ctr1_rdata;
+		ADDR_CTR1H: rdata = __ctr1h_rdata;
+		ADDR_CTR2: rdata = __ctr2_rdata;
+		ADDR_CTR2H: rdata = __ctr2h_rdata;
+		ADDR_CTR3: rdata = __ctr3_rdata;
+		ADDR_CTR3H: rdata = __ctr3h_rdata;
+		default: rdata = 32'h0;
+	endcase
+	ctr0_wen = __ctr0_wen;
+	ctr0_o = ctr0_wdata;
+	ctr0_ren = __ctr0_ren;
+	ctr0h_wen = __ctr0h_wen;
+	ctr0h_o = ctr0h_wdata;
+	ctr0h_ren = __ctr0h_ren;
+	ctr1_wen = __ctr1_wen;
+	ctr1_o = ctr1_wdata;
+	ctr1_ren = __ctr1_ren;
+	ctr1h_wen = __ctr1h_wen;
+	ctr1h_o = ctr1h_wdata;
+	ctr1h_ren = __ctr1h_ren;
+	ctr2_wen = __ctr2_wen;
+	ctr2_o = ctr2_wdata;
+	ctr2_ren = __ctr2_ren;
+	ctr2h_wen = __ctr2h_wen;
+	ctr2h_o = ctr2h_wdata;
+	ctr2h_ren = __ctr2h_ren;
+	ctr3_wen = __ctr3_wen;
+	ctr3_o = ctr3_wdata;
+	ctr3_ren = __ctr3_ren;
+	ctr3h_wen = __ctr3h_wen;
+	ctr3h_o = ctr3h_wdata;
+	ctr3h_ren = __ctr3h_ren;
+end
+
+always @ (posedge clk or negedge rst_n) begin
+	if (!rst_n) begin
+		ctrl_o <= 4'h0;
+		sel0_o <= 5'h0;
+		sel1_o <= 5'h0;
+		sel2_o <= 5'h0;
+		sel3_o <= 5'h0;
+	end else begin
+		if (__ctrl_wen)
+			ctrl_o <= ctrl_wdata;
+		if (__sel0_wen)
+			sel0_o <= sel0_wdata;
+		if (__sel1_wen)
+			sel1_o <= sel1_wdata;
+		if (__sel2_wen)
+			sel2_o <= sel2_wdata;
+		if (__sel3_wen)
+			sel3_o <= sel3_wdata;
+	end
+end
+
+endmodule
@@ -0,0 +1,2 @@
+file ahbl_sdram_openpage.v
+file sdramctrl_regs.v
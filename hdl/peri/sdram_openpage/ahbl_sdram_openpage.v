@@ -0,0 +1,584 @@
+/*****************************************************************************\
+|                        Copyright (C) 2021 Luke Wren                         |
+|                     SPDX-License-Identifier: Apache-2.0                     |
+\*****************************************************************************/
+
+// AHB-Lite SDRAM controller with per-bank row tracking and a selectable page
+// policy. Drives the same PHY interface as libfpga's ahbl_sdram, and has the
+// same register layout, plus CSR_OPEN_PAGE.
+//
+// Address mapping is column, then bank, then row, so consecutive 2 KiB pages
+// (with 10 column bits) fall in different banks. Every access is one 8-beat
+// burst (the SDRAM mode register must select 8-beat sequential bursts), which
+// is one 16-byte cache line. A WRAP4 or aligned INCR4 word burst is one burst
+// on the SDRAM. Any other AHB transfer is done as its own burst: reads use the
+// first two beats, and writes mask the unused beats with DQM.
+//
+// The controller remembers which row each bank has open:
+//
+// - With CSR_OPEN_PAGE clear (close-page), every Read/Write auto-precharges,
+//   so rows are only open between their Activate and their access.
+//
+// - With CSR_OPEN_PAGE set (open-page), rows stay open after an access. An
+//   access to the open row goes straight to Read/Write. An access to another
+//   row in the same bank precharges first. Refresh closes all banks.
+//
+// Activates and precharges are issued whilst another bank's data burst is on
+// the DQs: the next access is taken from the AHB address bus as soon as it
+// appears there (normally during the last data phase of the previous one), and
+// write data is buffered so the AHB transfer can finish before its burst. Only
+// the Read/Write command waits for the DQs to be free.
+
+`default_nettype none
+
+module ahbl_sdram_openpage #(
+	parameter COLUMN_BITS     = 10, // At most 10, as A10 is the precharge flag
+	parameter ROW_BITS        = 13,
+	parameter W_SDRAM_BANKSEL = 2,
+	parameter W_SDRAM_ADDR    = 13,
+	parameter W_SDRAM_DATA    = 16, // Must be W_HDATA / 2
+	parameter W_HADDR         = 32,
+	parameter W_HDATA         = 32
+) (
+	input  wire                       clk,
+	input  wire                       rst_n,
+
+	// SDRAM PHY. Command, address and write data are registered by the PHY
+	// before going to the pins. Read data arrives two cycles after the SDRAM
+	// drives it.
+	output wire                       phy_clk_enable,
+	output wire [W_SDRAM_BANKSEL-1:0] phy_ba_next,
+	output wire [W_SDRAM_ADDR-1:0]    phy_a_next,
+	output wire [W_SDRAM_DATA/8-1:0]  phy_dqm_next,
+
+	output wire [W_SDRAM_DATA-1:0]    phy_dq_o_next,
+	output wire                       phy_dq_oe_next,
+	input  wire [W_SDRAM_DATA-1:0]    phy_dq_i,
+
+	output wire                       phy_clke_next,
+	output wire                       phy_cs_n_next,
+	output wire                       phy_ras_n_next,
+	output wire                       phy_cas_n_next,
+	output wire                       phy_we_n_next,
+
+	// APB configuration slave
+	input  wire                       apbs_psel,
+	input  wire                       apbs_penable,
+	input  wire                       apbs_pwrite,
+	input  wire [15:0]                apbs_paddr,
+	input  wire [31:0]                apbs_pwdata,
+	output wire [31:0]                apbs_prdata,
+	output wire                       apbs_pready,
+	output wire                       apbs_pslverr,
+
+	// AHB-Lite slave
+	input  wire                       ahbls_hready,
+	output wire                       ahbls_hready_resp,
+	output wire                       ahbls_hresp,
+	input  wire [W_HADDR-1:0]         ahbls_haddr,
+	input  wire                       ahbls_hwrite,
+	input  wire [1:0]                 ahbls_htrans,
+	input  wire [2:0]                 ahbls_hsize,
+	input  wire [2:0]                 ahbls_hburst,
+	input  wire [3:0]                 ahbls_hprot,
+	input  wire                       ahbls_hmastlock,
+	input  wire [W_HDATA-1:0]         ahbls_hwdata,
+	output wire [W_HDATA-1:0]         ahbls_hrdata
+);
+
+localparam N_BANKS = 1 << W_SDRAM_BANKSEL;
+localparam BANK_LSB = COLUMN_BITS + 1;
+localparam ROW_LSB = BANK_LSB + W_SDRAM_BANKSEL;
+localparam W_DQM = W_SDRAM_DATA / 8;
+
+// {RAS_n, CAS_n, WE_n}
+localparam [2:0] CMD_LOAD_MODE = 3'b000;
+localparam [2:0] CMD_REFRESH   = 3'b001;
+localparam [2:0] CMD_PRECHARGE = 3'b010;
+localparam [2:0] CMD_ACTIVATE  = 3'b011;
+localparam [2:0] CMD_WRITE     = 3'b100;
+localparam [2:0] CMD_READ      = 3'b101;
+localparam [2:0] CMD_NOP       = 3'b111;
+
+localparam [1:0] HTRANS_NSEQ = 2'b10;
+localparam [1:0] HTRANS_SEQ  = 2'b11;
+localparam [2:0] HBURST_WRAP4 = 3'b010;
+localparam [2:0] HBURST_INCR4 = 3'b011;
+
+// ----------------------------------------------------------------------------
+// Control registers
+
+wire                       csr_en;
+wire                       csr_pu;
+wire                       csr_open_page;
+wire [2:0]                 time_rc;
+wire [2:0]                 time_rcd;
+wire [2:0]                 time_rp;
+wire [2:0]                 time_rrd;
+wire [2:0]                 time_ras;
+wire [2:0]                 time_wr;
+wire [1:0]                 time_cas;
+wire [11:0]                refresh_interval;
+wire                       cmd_direct_we_n;
+wire                       cmd_direct_cas_n;
+wire                       cmd_direct_ras_n;
+wire [12:0]                cmd_direct_addr;
+wire [1:0]                 cmd_direct_ba;
+wire                       cmd_direct_wen;
+
+sdramctrl_regs regs (
+	.clk                (clk),
+	.rst_n              (rst_n),
+
+	.apbs_psel          (apbs_psel),
+	.apbs_penable       (apbs_penable),
+	.apbs_pwrite        (apbs_pwrite),
+	.apbs_paddr         (apbs_paddr),
+	.apbs_pwdata        (apbs_pwdata),
+	.apbs_prdata        (apbs_prdata),
+	.apbs_pready        (apbs_pready),
+	.apbs_pslverr       (apbs_pslverr),
+
+	.csr_en_o           (csr_en),
+	.csr_pu_o           (csr_pu),
+	.csr_open_page_o    (csr_open_page),
+	.time_rc_o          (time_rc),
+	.time_rcd_o         (time_rcd),
+	.time_rp_o          (time_rp),
+	.time_rrd_o         (time_rrd),
+	.time_ras_o         (time_ras),
+	.time_wr_o          (time_wr),
+	.time_cas_o         (time_cas),
+	.refresh_o          (refresh_interval),
+	.cmd_direct_we_n_o  (cmd_direct_we_n),
+	.cmd_direct_cas_n_o (cmd_direct_cas_n),
+	.cmd_direct_ras_n_o (cmd_direct_ras_n),
+	.cmd_direct_addr_o  (cmd_direct_addr),
+	.cmd_direct_ba_o    (cmd_direct_ba),
+	.cmd_direct_wen     (cmd_direct_wen)
+);
+
+reg                        direct_pending;
+reg [2:0]                  direct_cmd;
+reg [W_SDRAM_BANKSEL-1:0]  direct_ba;
+reg [W_SDRAM_ADDR-1:0]     direct_addr;
+
+always @ (posedge clk or negedge rst_n) begin
+	if (!rst_n) begin
+		direct_pending <= 1'b0;
+		direct_cmd <= CMD_NOP;
+		direct_ba <= {W_SDRAM_BANKSEL{1'b0}};
+		direct_addr <= {W_SDRAM_ADDR{1'b0}};
+	end else begin
+		direct_pending <= cmd_direct_wen;
+		if (cmd_direct_wen) begin
+			direct_cmd <= {cmd_direct_ras_n, cmd_direct_cas_n, cmd_direct_we_n};
+			direct_ba <= cmd_direct_ba;
+			direct_addr <= cmd_direct_addr;
+		end
+	end
+end
+
+reg [11:0] refresh_ctr;
+reg        refresh_pending;
+wire       issue_refresh;
+
+always @ (posedge clk or negedge rst_n) begin
+	if (!rst_n) begin
+		refresh_ctr <= 12'h0;
+		refresh_pending <= 1'b0;
+	end else if (!csr_en) begin
+		refresh_ctr <= refresh_interval;
+		refresh_pending <= 1'b0;
+	end else begin
+		refresh_ctr <= |refresh_ctr ? refresh_ctr - 12'h1 : refresh_interval;
+		refresh_pending <= (refresh_pending && !issue_refresh) || ~|refresh_ctr;
+	end
+end
+
+// ----------------------------------------------------------------------------
+// AHB-Lite interface
+
+wire aphase = ahbls_hready && ahbls_htrans[1];
+
+wire aph_burst4 = ahbls_hsize == 3'h2 && (ahbls_hburst == HBURST_WRAP4 ||
+	ahbls_hburst == HBURST_INCR4 && ahbls_haddr[3:2] == 2'h0);
+
+reg       trans_burst4;
+reg [1:0] trans_beat;
+
+// SEQ beats of a 4-beat burst belong to the access started by its NONSEQ.
+// Any other transfer starts a new access.
+wire aph_new = aphase && !(ahbls_htrans == HTRANS_SEQ && trans_burst4);
+
+reg [3:0] aph_strb;
+
+always @ (*) begin
+	case (ahbls_hsize[1:0])
+	2'h0:    aph_strb = 4'h1 << ahbls_haddr[1:0];
+	2'h1:    aph_strb = ahbls_haddr[1] ? 4'hc : 4'h3;
+	default: aph_strb = 4'hf;
+	endcase
+end
+
+// The access waiting for the command scheduler. Cleared when its Read/Write
+// is issued, which is always before its AHB transfer finishes.
+reg                       req_valid;
+reg                       req_write;
+reg                       req_burst4;
+reg [3:0]                 req_strb;
+reg [W_SDRAM_BANKSEL-1:0] req_bank;
+reg [ROW_BITS-1:0]        req_row;
+reg [COLUMN_BITS-1:0]     req_col;
+
+wire issue_read;
+wire issue_write;
+wire issue_cas = issue_read || issue_write;
+
+always @ (posedge clk or negedge rst_n) begin
+	if (!rst_n) begin
+		req_valid <= 1'b0;
+		req_write <= 1'b0;
+		req_burst4 <= 1'b0;
+		req_strb <= 4'h0;
+		req_bank <= {W_SDRAM_BANKSEL{1'b0}};
+		req_row <= {ROW_BITS{1'b0}};
+		req_col <= {COLUMN_BITS{1'b0}};
+	end else if (aph_new && csr_en) begin
+		req_valid <= 1'b1;
+		req_write <= ahbls_hwrite;
+		req_burst4 <= aph_burst4;
+		req_strb <= aph_strb;
+		req_bank <= ahbls_haddr[BANK_LSB +: W_SDRAM_BANKSEL];
+		req_row <= ahbls_haddr[ROW_LSB +: ROW_BITS];
+		// Bursts start at the first word, and wrap at the line boundary
+		req_col <= {ahbls_haddr[COLUMN_BITS:2], 1'b0};
+	end else if (issue_cas) begin
+		req_valid <= 1'b0;
+	end
+end
+
+// Read data, gathered in burst order, which is also AHB beat order. rd_cur
+// means the buffer belongs to the current AHB transfer.
+reg [W_HDATA-1:0]      rbuf [0:3];
+reg [2:0]              rbuf_words;
+reg                    rd_cur;
+
+// Write data, buffered so the AHB transfer can finish before its burst
+reg [4*W_HDATA-1:0]    wbuf;
+reg                    wbuf_full;
+
+reg                    dph_active;
+reg                    dph_write;
+reg                    dph_err;
+reg                    dph_last;
+reg [1:0]              dph_beat;
+
+reg                    hready_resp;
+reg                    hresp;
+reg [W_HDATA-1:0]      hrdata;
+
+// Non-final write beats go into the buffer with no wait states. The final
+// write beat waits for its Write command, so that the buffer is free again
+// for the next transfer. Read beats wait for their data.
+always @ (posedge clk or negedge rst_n) begin
+	if (!rst_n) begin
+		trans_burst4 <= 1'b0;
+		trans_beat <= 2'h0;
+		dph_active <= 1'b0;
+		dph_write <= 1'b0;
+		dph_err <= 1'b0;
+		dph_last <= 1'b0;
+		dph_beat <= 2'h0;
+		hready_resp <= 1'b1;
+		hresp <= 1'b0;
+		hrdata <= {W_HDATA{1'b0}};
+	end else if (ahbls_hready) begin
+		dph_active <= aphase;
+		dph_write <= ahbls_hwrite;
+		// Two-cycle error response to any access whilst disabled
+		dph_err <= aphase && !csr_en;
+		hresp <= aphase && !csr_en;
+		hready_resp <= !aphase;
+		if (aph_new) begin
+			trans_burst4 <= aph_burst4;
+			trans_beat <= 2'h0;
+			dph_beat <= 2'h0;
+			dph_last <= !aph_burst4;
+			if (csr_en && ahbls_hwrite && aph_burst4)
+				hready_resp <= 1'b1;
+		end else if (aphase) begin
+			trans_beat <= trans_beat + 2'h1;
+			dph_beat <= trans_beat + 2'h1;
+			dph_last <= trans_beat == 2'h2;
+			if (csr_en && ahbls_hwrite && trans_beat != 2'h2) begin
+				hready_resp <= 1'b1;
+			end else if (csr_en && !ahbls_hwrite && rd_cur && rbuf_words > {1'b0, trans_beat + 2'h1}) begin
+				hready_resp <= 1'b1;
+				hrdata <= rbuf[trans_beat + 2'h1];
+			end
+		end
+	end else if (dph_active) begin
+		if (dph_err) begin
+			hready_resp <= 1'b1;
+		end else if (dph_write) begin
+			hready_resp <= !req_valid || issue_write;
+		end else if (rd_cur && rbuf_words > {1'b0, dph_beat}) begin
+			hready_resp <= 1'b1;
+			hrdata <= rbuf[dph_beat];
+		end
+	end
+end
+
+always @ (posedge clk or negedge rst_n) begin
+	if (!rst_n) begin
+		wbuf <= {4*W_HDATA{1'b0}};
+		wbuf_full <= 1'b0;
+	end else begin
+		if (dph_active && dph_write && !dph_err)
+			wbuf[dph_beat * W_HDATA +: W_HDATA] <= ahbls_hwdata;
+		if (issue_write)
+			wbuf_full <= 1'b0;
+		else if (dph_active && dph_write && !dph_err && dph_last && req_valid)
+			wbuf_full <= 1'b1;
+	end
+end
+
+assign ahbls_hready_resp = hready_resp;
+assign ahbls_hresp = hresp;
+assign ahbls_hrdata = hrdata;
+
+// ----------------------------------------------------------------------------
+// Data bursts
+
+reg [2:0]              rd_wait;
+reg [2:0]              rd_beat;
+reg                    rd_busy;
+reg [W_SDRAM_DATA-1:0] rd_lo;
+
+always @ (posedge clk or negedge rst_n) begin
+	if (!rst_n) begin
+		rd_wait <= 3'h0;
+		rd_beat <= 3'h0;
+		rd_busy <= 1'b0;
+		rd_cur <= 1'b0;
+		rbuf_words <= 3'h0;
+	end else if (issue_read) begin
+		// First beat reaches phy_dq_i CAS latency + 2 cycles after the Read
+		rd_wait <= {1'b0, time_cas} + 3'h2;
+		rd_beat <= 3'h0;
+		rd_busy <= 1'b1;
+		rd_cur <= 1'b1;
+		rbuf_words <= 3'h0;
+	end else begin
+		if (aph_new)
+			rd_cur <= 1'b0;
+		if (rd_busy && |rd_wait) begin
+			rd_wait <= rd_wait - 3'h1;
+		end else if (rd_busy) begin
+			rd_beat <= rd_beat + 3'h1;
+			rd_busy <= rd_beat != 3'h7;
+			if (rd_beat[0])
+				rbuf_words <= {1'b0, rd_beat[2:1]} + 3'h1;
+		end
+	end
+end
+
+always @ (posedge clk) begin
+	if (rd_busy && ~|rd_wait) begin
+		if (rd_beat[0])
+			rbuf[rd_beat[2:1]] <= {phy_dq_i, rd_lo};
+		else
+			rd_lo <= phy_dq_i;
+	end
+end
+
+// Beat 0 of a write goes out with the Write command, straight from the
+// buffer, and the rest are shifted out of a copy, so the buffer is free for
+// the next transfer.
+wire [8*W_DQM-1:0]       req_dqm = req_burst4 ? {8*W_DQM{1'b0}} : {{6*W_DQM{1'b1}}, ~req_strb};
+
+reg [7*W_SDRAM_DATA-1:0] wr_shift;
+reg [7*W_DQM-1:0]        wr_dqm_shift;
+reg [2:0]                wr_left;
+
+always @ (posedge clk or negedge rst_n) begin
+	if (!rst_n) begin
+		wr_shift <= {7*W_SDRAM_DATA{1'b0}};
+		wr_dqm_shift <= {7*W_DQM{1'b0}};
+		wr_left <= 3'h0;
+	end else if (issue_write) begin
+		wr_shift <= wbuf[8*W_SDRAM_DATA-1:W_SDRAM_DATA];
+		wr_dqm_shift <= req_dqm[8*W_DQM-1:W_DQM];
+		wr_left <= 3'h7;
+	end else if (|wr_left) begin
+		wr_shift <= wr_shift >> W_SDRAM_DATA;
+		wr_dqm_shift <= wr_dqm_shift >> W_DQM;
+		wr_left <= wr_left - 3'h1;
+	end
+end
+
+wire dq_idle = !rd_busy && ~|wr_left;
+
+// ----------------------------------------------------------------------------
+// Bank state and command scheduling
+
+// Each counter is the number of cycles before that command is allowed on
+// that bank. Loading n allows the command n + 1 cycles later.
+reg [N_BANKS-1:0]  bank_open;
+reg [ROW_BITS-1:0] bank_row [0:N_BANKS-1];
+reg [4:0]          act_ctr  [0:N_BANKS-1]; // tRC, tRP, tRFC, auto-precharge
+reg [2:0]          cas_ctr  [0:N_BANKS-1]; // tRCD
+reg [3:0]          pre_ctr  [0:N_BANKS-1]; // tRAS, end of burst, tWR
+reg [2:0]          rrd_ctr;
+
+reg [N_BANKS-1:0]  act_ok;
+reg [N_BANKS-1:0]  pre_ok;
+reg [N_BANKS-1:0]  cas_ok;
+
+integer b;
+
+always @ (*) begin
+	for (b = 0; b < N_BANKS; b = b + 1) begin
+		act_ok[b] = ~|act_ctr[b];
+		pre_ok[b] = ~|pre_ctr[b];
+		cas_ok[b] = ~|cas_ctr[b];
+	end
+end
+
+// Prepare the bank for the waiting access, or if there is none, for the one
+// being presented on the bus.
+wire peek = !req_valid && ahbls_htrans == HTRANS_NSEQ;
+
+wire [W_SDRAM_BANKSEL-1:0] tgt_bank = req_valid ? req_bank : ahbls_haddr[BANK_LSB +: W_SDRAM_BANKSEL];
+wire [ROW_BITS-1:0]        tgt_row  = req_valid ? req_row  : ahbls_haddr[ROW_LSB +: ROW_BITS];
+wire                       tgt_open = bank_open[tgt_bank];
+wire                       tgt_hit  = tgt_open && bank_row[tgt_bank] == tgt_row;
+
+wire cas_ready = cas_ok[tgt_bank] && dq_idle && (wbuf_full || !req_write);
+
+reg [2:0]                 cmd;
+reg [W_SDRAM_BANKSEL-1:0] cmd_ba;
+reg [W_SDRAM_ADDR-1:0]    cmd_a;
+
+always @ (*) begin
+	cmd = CMD_NOP;
+	cmd_ba = tgt_bank;
+	cmd_a = {W_SDRAM_ADDR{1'b0}};
+	if (direct_pending) begin
+		cmd = direct_cmd;
+		cmd_ba = direct_ba;
+		cmd_a = direct_addr;
+	end else if (!csr_en) begin
+		cmd = CMD_NOP;
+	end else if (refresh_pending) begin
+		// PrechargeAll, then Refresh. Let bursts finish first, as a
+		// PrechargeAll would cut short a burst with auto-precharge.
+		if (|bank_open) begin
+			if (&(pre_ok | ~bank_open) && dq_idle) begin
+				cmd = CMD_PRECHARGE;
+				cmd_a[10] = 1'b1;
+			end
+		end else if (&act_ok && dq_idle) begin
+			cmd = CMD_REFRESH;
+		end
+	end else if (req_valid || peek) begin
+		if (tgt_hit) begin
+			if (req_valid && cas_ready) begin
+				cmd = req_write ? CMD_WRITE : CMD_READ;
+				cmd_a[COLUMN_BITS-1:0] = req_col;
+				cmd_a[10] = !csr_open_page;
+			end
+		end else if (tgt_open) begin
+			if (pre_ok[tgt_bank])
+				cmd = CMD_PRECHARGE;
+		end else if (act_ok[tgt_bank] && ~|rrd_ctr) begin
+			cmd = CMD_ACTIVATE;
+			cmd_a = tgt_row;
+		end
+	end
+end
+
+wire sched_cmd = csr_en && !direct_pending;
+wire issue_activate = sched_cmd && cmd == CMD_ACTIVATE;
+wire issue_precharge = sched_cmd && cmd == CMD_PRECHARGE;
+assign issue_refresh = sched_cmd && cmd == CMD_REFRESH;
+assign issue_read = sched_cmd && cmd == CMD_READ;
+assign issue_write = sched_cmd && cmd == CMD_WRITE;
+wire auto_precharge = cmd_a[10];
+
+function [4:0] max5;
+	input [4:0] a;
+	input [4:0] b;
+begin
+	max5 = a > b ? a : b;
+end
+endfunction
+
+integer i;
+
+always @ (posedge clk or negedge rst_n) begin
+	if (!rst_n) begin
+		bank_open <= {N_BANKS{1'b0}};
+		rrd_ctr <= 3'h0;
+		for (i = 0; i < N_BANKS; i = i + 1) begin
+			bank_row[i] <= {ROW_BITS{1'b0}};
+			act_ctr[i] <= 5'h0;
+			cas_ctr[i] <= 3'h0;
+			pre_ctr[i] <= 4'h0;
+		end
+	end else begin
+		rrd_ctr <= issue_activate ? time_rrd : rrd_ctr - {2'h0, |rrd_ctr};
+		for (i = 0; i < N_BANKS; i = i + 1) begin
+			act_ctr[i] <= act_ctr[i] - {4'h0, |act_ctr[i]};
+			cas_ctr[i] <= cas_ctr[i] - {2'h0, |cas_ctr[i]};
+			pre_ctr[i] <= pre_ctr[i] - {3'h0, |pre_ctr[i]};
+			if (issue_activate && cmd_ba == i) begin
+				bank_open[i] <= 1'b1;
+				bank_row[i] <= tgt_row;
+				act_ctr[i] <= {2'h0, time_rc};
+				cas_ctr[i] <= time_rcd;
+				pre_ctr[i] <= {1'b0, time_ras};
+			end
+			if (issue_precharge && (cmd_ba == i || auto_precharge)) begin
+				bank_open[i] <= 1'b0;
+				act_ctr[i] <= max5(act_ctr[i] - {4'h0, |act_ctr[i]}, {2'h0, time_rp});
+			end
+			if (issue_refresh) begin
+				act_ctr[i] <= max5(act_ctr[i] - {4'h0, |act_ctr[i]}, {2'h0, time_rc});
+			end
+			if (issue_cas && cmd_ba == i && auto_precharge) begin
+				// Precharge starts after the last read beat, or tWR after
+				// the last write beat
+				bank_open[i] <= 1'b0;
+				act_ctr[i] <= max5(act_ctr[i] - {4'h0, |act_ctr[i]}, issue_write ?
+					5'd8 + time_wr + time_rp : 5'd7 + time_rp);
+			end else if (issue_cas && cmd_ba == i) begin
+				pre_ctr[i] <= issue_write ? 4'd7 + time_wr : 4'd7;
+			end
+		end
+		if (!csr_en)
+			bank_open <= {N_BANKS{1'b0}};
+	end
+end
+
+// ----------------------------------------------------------------------------
+// PHY outputs
+
+assign phy_clk_enable = csr_pu;
+assign phy_clke_next = csr_pu;
+assign phy_cs_n_next = cmd == CMD_NOP;
+assign {phy_ras_n_next, phy_cas_n_next, phy_we_n_next} = cmd;
+assign phy_ba_next = cmd_ba;
+assign phy_a_next = cmd_a;
+
+assign phy_dq_o_next = issue_write ? wbuf[W_SDRAM_DATA-1:0] : wr_shift[W_SDRAM_DATA-1:0];
+assign phy_dq_oe_next = issue_write || |wr_left;
+assign phy_dqm_next = issue_write ? req_dqm[W_DQM-1:0] :
+	|wr_left ? wr_dqm_shift[W_DQM-1:0] : {W_DQM{1'b0}};
+
+endmodule
+
+`ifndef YOSYS
+`default_nettype wire
+`endif
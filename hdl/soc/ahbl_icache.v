@@ -0,0 +1,263 @@
+/*****************************************************************************\
+|                        Copyright (C) 2021 Luke Wren                         |
+|                     SPDX-License-Identifier: Apache-2.0                     |
+\*****************************************************************************/
+
+// Small private instruction cache, for one core, sitting between the core's
+// bus splitter and the shared cache arbiter.
+//
+// Only opcode fetches (HPROT[0] == 0) from the cacheable SDRAM window are
+// looked up. All other transfers pass straight through with no added latency.
+// The cache is direct-mapped with one-word lines, so a hit completes with no
+// wait states, and a miss costs one downstream read plus one cycle.
+//
+// Hazard3 does not bring out fence.i, so instead the cache snoops writes on
+// the shared bus downstream of the arbiter (from either core, or the DMA), and
+// invalidates any line they hit. Code written through the shared cache is
+// therefore visible to subsequent fetches without any explicit maintenance,
+// and fence.i keeps the usual RISC-V meaning of "wait for prior stores".
+// Writes which bypass the shared bus can be handled with `invalidate`.
+
+`default_nettype none
+
+module ahbl_icache #(
+	parameter W_ADDR       = 32,
+	parameter W_DATA       = 32,
+	parameter SIZE_BYTES   = 1024,
+	// Lookups are restricted to addresses where haddr[W_REGION-1] is 0, i.e.
+	// the lower half of the 2^W_REGION bytes seen through the shared cache.
+	parameter W_REGION     = 27,
+	parameter N_LINES      = SIZE_BYTES / (W_DATA / 8), // do not modify
+	parameter W_INDEX      = $clog2(N_LINES),           // do not modify
+	parameter W_OFFS       = $clog2(W_DATA / 8),        // do not modify
+	parameter W_TAG        = W_REGION - 1 - W_INDEX - W_OFFS // do not modify
+) (
+	input  wire              clk,
+	input  wire              rst_n,
+
+	// Upstream port, from the core
+	input  wire              src_hready,
+	output reg               src_hready_resp,
+	output reg               src_hresp,
+	output reg               src_hexokay,
+	input  wire [W_ADDR-1:0] src_haddr,
+	input  wire              src_hwrite,
+	input  wire [1:0]        src_htrans,
+	input  wire [2:0]        src_hsize,
+	input  wire [2:0]        src_hburst,
+	input  wire [3:0]        src_hprot,
+	input  wire [7:0]        src_hmaster,
+	input  wire              src_hmastlock,
+	input  wire              src_hexcl,
+	input  wire [W_DATA-1:0] src_hwdata,
+	output reg  [W_DATA-1:0] src_hrdata,
+
+	// Downstream port, to the shared cache arbiter
+	output wire              dst_hready,
+	input  wire              dst_hready_resp,
+	input  wire              dst_hresp,
+	input  wire              dst_hexokay,
+	output wire [W_ADDR-1:0] dst_haddr,
+	output wire              dst_hwrite,
+	output wire [1:0]        dst_htrans,
+	output wire [2:0]        dst_hsize,
+	output wire [2:0]        dst_hburst,
+	output wire [3:0]        dst_hprot,
+	output wire [7:0]        dst_hmaster,
+	output wire              dst_hmastlock,
+	output wire              dst_hexcl,
+	output wire [W_DATA-1:0] dst_hwdata,
+	input  wire [W_DATA-1:0] dst_hrdata,
+
+	// Write snoop, from the shared bus downstream of the arbiter
+	input  wire              snoop_hready,
+	input  wire [1:0]        snoop_htrans,
+	input  wire              snoop_hwrite,
+	input  wire [W_ADDR-1:0] snoop_haddr,
+
+	// Invalidate all lines (e.g. from software, via cache_ctrl)
+	input  wire              invalidate,
+
+	// Event strobes for performance counters
+	output wire              stat_hit,
+	output wire              stat_miss
+);
+
+// ----------------------------------------------------------------------------
+// Address phase decode
+
+wire src_aphase = src_htrans[1] && src_hready;
+
+wire src_cacheable = src_htrans[1] && !src_hwrite && !src_hprot[0] && !src_hexcl &&
+	src_hsize == W_OFFS && !src_haddr[W_REGION-1];
+
+wire [W_INDEX-1:0] src_index = src_haddr[W_OFFS +: W_INDEX];
+wire [W_TAG-1:0]   src_tag   = src_haddr[W_OFFS + W_INDEX +: W_TAG];
+
+// ----------------------------------------------------------------------------
+// Data phase state
+
+reg                dph_cached;    // Data phase is a fetch handled by this cache
+reg                dph_pass;      // Data phase was passed downstream
+reg                dph_lookup;    // First cycle of a cached data phase
+reg [W_ADDR-1:0]   dph_haddr;
+reg [3:0]          dph_hprot;
+reg [7:0]          dph_hmaster;
+
+reg                fill_aphase;   // Fill address phase not yet accepted downstream
+reg                fill_dphase;   // Fill data phase in progress downstream
+reg                fill_poison;   // Line was written during the fill: don't keep it
+
+wire [W_INDEX-1:0] dph_index = dph_haddr[W_OFFS +: W_INDEX];
+wire [W_TAG-1:0]   dph_tag   = dph_haddr[W_OFFS + W_INDEX +: W_TAG];
+
+// ----------------------------------------------------------------------------
+// Tag/data RAM and valid flags
+
+reg [N_LINES-1:0]      valid;
+reg [W_TAG+W_DATA-1:0] mem [0:N_LINES-1];
+reg [W_TAG+W_DATA-1:0] mem_rdata;
+
+// A fill may complete in the same cycle the next fetch is looked up. If they
+// are to the same line, forward the fill data instead of the old RAM contents.
+reg                    bypass;
+reg [W_TAG+W_DATA-1:0] bypass_data;
+
+wire snoop_write = snoop_hready && snoop_htrans[1] && snoop_hwrite;
+wire [W_INDEX-1:0] snoop_index = snoop_haddr[W_OFFS +: W_INDEX];
+
+wire mem_ren = src_aphase && src_cacheable;
+wire fill_done = fill_dphase && dst_hready_resp;
+wire fill_keep = !dst_hresp && !fill_poison && !invalidate &&
+	!(snoop_write && snoop_index == dph_index);
+wire mem_wen = fill_done && fill_keep;
+wire [W_TAG+W_DATA-1:0] mem_wdata = {dph_tag, dst_hrdata};
+
+always @ (posedge clk) begin
+	if (mem_wen) begin
+		mem[dph_index] <= mem_wdata;
+	end
+	if (mem_ren) begin
+		mem_rdata <= mem[src_index];
+		bypass <= mem_wen && src_index == dph_index;
+		bypass_data <= mem_wdata;
+	end
+end
+
+wire [W_TAG+W_DATA-1:0] lookup_rdata = bypass ? bypass_data : mem_rdata;
+
+wire hit  = dph_lookup && valid[dph_index] && lookup_rdata[W_DATA +: W_TAG] == dph_tag;
+wire miss = dph_lookup && !hit;
+wire fill_req = miss || fill_aphase;
+
+assign stat_hit = hit;
+assign stat_miss = miss;
+
+always @ (posedge clk or negedge rst_n) begin
+	if (!rst_n) begin
+		valid <= {N_LINES{1'b0}};
+	end else if (invalidate) begin
+		valid <= {N_LINES{1'b0}};
+	end else begin
+		if (snoop_write) begin
+			valid[snoop_index] <= 1'b0;
+		end
+		// Takes priority, but fill_keep is false if the snoop hit this line
+		if (mem_wen) begin
+			valid[dph_index] <= 1'b1;
+		end
+	end
+end
+
+// ----------------------------------------------------------------------------
+// Bus state machine
+
+always @ (posedge clk or negedge rst_n) begin
+	if (!rst_n) begin
+		dph_cached <= 1'b0;
+		dph_pass <= 1'b0;
+		dph_lookup <= 1'b0;
+		dph_haddr <= {W_ADDR{1'b0}};
+		dph_hprot <= 4'h0;
+		dph_hmaster <= 8'h00;
+		fill_aphase <= 1'b0;
+		fill_dphase <= 1'b0;
+		fill_poison <= 1'b0;
+	end else begin
+		dph_lookup <= 1'b0;
+		if (src_hready) begin
+			dph_cached <= src_aphase && src_cacheable;
+			dph_pass <= src_aphase && !src_cacheable;
+			dph_lookup <= src_aphase && src_cacheable;
+			if (src_aphase && src_cacheable) begin
+				dph_haddr <= src_haddr;
+				dph_hprot <= src_hprot;
+				dph_hmaster <= src_hmaster;
+			end
+		end
+		if (fill_req) begin
+			fill_aphase <= !dst_hready_resp;
+			fill_dphase <= dst_hready_resp;
+			fill_poison <= 1'b0;
+		end else if (fill_done) begin
+			fill_dphase <= 1'b0;
+		end
+		if ((invalidate || snoop_write && snoop_index == dph_index) && (fill_req || fill_dphase)) begin
+			fill_poison <= 1'b1;
+		end
+	end
+end
+
+// ----------------------------------------------------------------------------
+// Downstream address phase: either our own fill, or whatever the core is
+// presenting, minus the fetches we handle ourselves. A forwarded address
+// phase is accepted on both sides at once, because downstream hready follows
+// the core's hready except while our fill address phase is outstanding (when
+// there is no downstream data phase in progress).
+
+wire fwd = !fill_req && !src_cacheable;
+
+assign dst_hready    = fill_req ? dst_hready_resp : src_hready;
+assign dst_htrans    = fill_req ? 2'b10      : fwd ? src_htrans : 2'b00;
+assign dst_haddr     = fill_req ? dph_haddr   : src_haddr;
+assign dst_hwrite    = fill_req ? 1'b0        : src_hwrite;
+assign dst_hsize     = fill_req ? W_OFFS      : src_hsize;
+assign dst_hburst    = fill_req ? 3'h0        : src_hburst;
+assign dst_hprot     = fill_req ? dph_hprot   : src_hprot;
+assign dst_hmaster   = fill_req ? dph_hmaster : src_hmaster;
+assign dst_hmastlock = fill_req ? 1'b0        : src_hmastlock;
+assign dst_hexcl     = fill_req ? 1'b0        : src_hexcl;
+assign dst_hwdata    = src_hwdata;
+
+// ----------------------------------------------------------------------------
+// Upstream response
+
+always @ (*) begin
+	if (dph_cached && fill_dphase) begin
+		src_hready_resp = dst_hready_resp;
+		src_hresp = dst_hresp;
+		src_hexokay = 1'b0;
+		src_hrdata = dst_hrdata;
+	end else if (dph_cached) begin
+		src_hready_resp = hit;
+		src_hresp = 1'b0;
+		src_hexokay = 1'b0;
+		src_hrdata = lookup_rdata[W_DATA-1:0];
+	end else if (dph_pass) begin
+		src_hready_resp = dst_hready_resp;
+		src_hresp = dst_hresp;
+		src_hexokay = dst_hexokay;
+		src_hrdata = dst_hrdata;
+	end else begin
+		src_hready_resp = 1'b1;
+		src_hresp = 1'b0;
+		src_hexokay = 1'b0;
+		src_hrdata = {W_DATA{1'b0}};
+	end
+end
+
+endmodule
+
+`ifndef YOSYS
+`default_nettype wire
+`endif
@@ -1,4 +1,5 @@
 file soc.v
+file ahbl_icache.v
 list $HDL/hazard3/hdl/hazard3.f
 list $HDL/hazard3/hdl/debug/dtm/hazard3_jtag_dtm.f
 list $HDL/hazard3/hdl/debug/dtm/hazard3_ecp5_jtag_dtm.f
@@ -6,6 +7,10 @@ list $HDL/hazard3/hdl/debug/dm/hazard3_dm.f
 
 list $HDL/peri/platform_timer/platform_timer.f
 list $HDL/peri/gpio/gpio.f
+list $HDL/peri/perf_counters/perf_counters.f
+list $HDL/peri/cache_ctrl/cache_ctrl.f
+list $HDL/peri/dma/dma.f
+list $HDL/peri/sdram_openpage/ahbl_sdram_openpage.f
 
 list $HDL/libfpga/busfabric/busfabric.f
 list $HDL/libfpga/mem/ahb_cache.f
@@ -13,6 +18,7 @@ list $HDL/libfpga/mem/ahb_sync_sram.f
 
 list $HDL/libfpga/peris/uart/uart.f
 list $HDL/libfpga/peris/spi/spi.f
+list $HDL/libfpga/peris/spi_03h_xip/spi_03h_xip.f
 list $HDL/libfpga/sdram/ahbl_sdram.f
 
 file $HDL/libfpga/common/reset_sync.v
@@ -12,12 +12,18 @@
 // Current features:
 //
 // - Standard RISC-V debug (0.13.2) with multicore support
-// - Per-core local RAM (TCM) and shared system cache
-// - SDRAM controller
+// - Per-core local RAM (TCM) and shared system cache, with configurable
+//   associativity
+// - Per-core instruction caches, coherent with writes from either core or DMA
+// - Cache maintenance registers
+// - SDRAM controller: libfpga close-page, or in-tree open-page (SDRAM_CTRL)
 // - UART x1
 // - SPI x1
 // - Platform timer with two comparators, + soft IRQ regs
 // - GPIO registers
+// - Performance counters for cache, fabric and SDRAM events
+// - Two-channel DMA, sharing the system cache with the cores
+// - Execute-in-place window onto the SPI flash, cached by the system cache
 
 `default_nettype none
 
@@ -32,9 +38,23 @@ module christmas_soc #(
 	parameter TCM_PRELOAD_FILE = "",
 
 	parameter CACHE_SIZE_BYTES = 1 << 12,
+	// Associativity of the shared cache. CACHE_SIZE_BYTES is the total over
+	// all ways. With two cores running different working sets, a
+	// direct-mapped cache (1 way) thrashes on any aliasing lines, so the
+	// default is 2 ways.
+	parameter CACHE_N_WAYS     = 2,
+
+	// Size of each core's private instruction cache
+	parameter ICACHE_SIZE_BYTES = 1 << 10,
 
 	parameter N_GPIOS          = 8,
 
+	// Can be "LIBFPGA" or "OPEN_PAGE". "LIBFPGA" is libfpga's close-page
+	// ahbl_sdram. "OPEN_PAGE" is the in-tree controller in peri/sdram_openpage,
+	// which can also leave rows open between accesses (CSR.OPEN_PAGE). Both
+	// have the same register layout.
+	parameter SDRAM_CTRL       = "LIBFPGA",
+
 	parameter W_SDRAM_DATA     = 16,
 	parameter W_SDRAM_ADDR     = 13,
 	parameter W_SDRAM_BANKSEL  = 2
@@ -557,6 +577,7 @@ hazard3_cpu_1port #(
 // TCMs are at address                           32'h0000_0000 (same for both cores)
 // SDRAM (through cache, cached) is at address   32'h0800_0000 (must be 64M in size)
 // IO    (through cache, uncached) is at address 32'h0c00_0000
+// XIP   (through cache, cached) is at address   32'h0e00_0000
 
 wire [W_ADDR-1:0] cpu0_to_tcm_haddr;
 wire              cpu0_to_tcm_hwrite;
@@ -590,6 +611,22 @@ wire              cpu1_to_tcm_hexokay;
 wire [W_DATA-1:0] cpu1_to_tcm_hwdata;
 wire [W_DATA-1:0] cpu1_to_tcm_hrdata;
 
+wire [W_ADDR-1:0] cpu0_to_icache_haddr;
+wire              cpu0_to_icache_hwrite;
+wire [1:0]        cpu0_to_icache_htrans;
+wire [2:0]        cpu0_to_icache_hsize;
+wire [2:0]        cpu0_to_icache_hburst;
+wire [3:0]        cpu0_to_icache_hprot;
+wire [7:0]        cpu0_to_icache_hmaster;
+wire              cpu0_to_icache_hmastlock;
+wire              cpu0_to_icache_hexcl;
+wire              cpu0_to_icache_hready;
+wire              cpu0_to_icache_hready_resp;
+wire              cpu0_to_icache_hresp;
+wire              cpu0_to_icache_hexokay;
+wire [W_DATA-1:0] cpu0_to_icache_hwdata;
+wire [W_DATA-1:0] cpu0_to_icache_hrdata;
+
 wire [W_ADDR-1:0] cpu0_to_cache_haddr;
 wire              cpu0_to_cache_hwrite;
 wire [1:0]        cpu0_to_cache_htrans;
@@ -606,6 +643,22 @@ wire              cpu0_to_cache_hexokay;
 wire [W_DATA-1:0] cpu0_to_cache_hwdata;
 wire [W_DATA-1:0] cpu0_to_cache_hrdata;
 
+wire [W_ADDR-1:0] cpu1_to_icache_haddr;
+wire              cpu1_to_icache_hwrite;
+wire [1:0]        cpu1_to_icache_htrans;
+wire [2:0]        cpu1_to_icache_hsize;
+wire [2:0]        cpu1_to_icache_hburst;
+wire [3:0]        cpu1_to_icache_hprot;
+wire [7:0]        cpu1_to_icache_hmaster;
+wire              cpu1_to_icache_hmastlock;
+wire              cpu1_to_icache_hexcl;
+wire              cpu1_to_icache_hready;
+wire              cpu1_to_icache_hready_resp;
+wire              cpu1_to_icache_hresp;
+wire              cpu1_to_icache_hexokay;
+wire [W_DATA-1:0] cpu1_to_icache_hwdata;
+wire [W_DATA-1:0] cpu1_to_icache_hrdata;
+
 wire [W_ADDR-1:0] cpu1_to_cache_haddr;
 wire              cpu1_to_cache_hwrite;
 wire [1:0]        cpu1_to_cache_htrans;
@@ -622,6 +675,21 @@ wire              cpu1_to_cache_hexokay;
 wire [W_DATA-1:0] cpu1_to_cache_hwdata;
 wire [W_DATA-1:0] cpu1_to_cache_hrdata;
 
+wire [W_ADDR-1:0] dma_haddr;
+wire              dma_hwrite;
+wire [1:0]        dma_htrans;
+wire [2:0]        dma_hsize;
+wire [2:0]        dma_hburst;
+wire [3:0]        dma_hprot;
+wire [7:0]        dma_hmaster = 8'h02;
+wire              dma_hmastlock;
+wire              dma_hexcl = 1'b0;
+wire              dma_hready;
+wire              dma_hresp;
+wire              dma_hexokay;
+wire [W_DATA-1:0] dma_hwdata;
+wire [W_DATA-1:0] dma_hrdata;
+
 wire [W_ADDR-1:0] cache_src_haddr;
 wire              cache_src_hwrite;
 wire [1:0]        cache_src_htrans;
@@ -664,21 +732,21 @@ ahbl_splitter #(
 	.src_hwdata      (cpu0_hwdata   ),
 	.src_hrdata      (cpu0_hrdata   ),
 
-	.dst_hready      ({cpu0_to_cache_hready      , cpu0_to_tcm_hready     }),
-	.dst_hready_resp ({cpu0_to_cache_hready_resp , cpu0_to_tcm_hready_resp}),
-	.dst_hresp       ({cpu0_to_cache_hresp       , cpu0_to_tcm_hresp      }),
-	.dst_hexokay     ({cpu0_to_cache_hexokay     , cpu0_to_tcm_hexokay    }),
-	.dst_haddr       ({cpu0_to_cache_haddr       , cpu0_to_tcm_haddr      }),
-	.dst_hwrite      ({cpu0_to_cache_hwrite      , cpu0_to_tcm_hwrite     }),
-	.dst_htrans      ({cpu0_to_cache_htrans      , cpu0_to_tcm_htrans     }),
-	.dst_hsize       ({cpu0_to_cache_hsize       , cpu0_to_tcm_hsize      }),
-	.dst_hburst      ({cpu0_to_cache_hburst      , cpu0_to_tcm_hburst     }),
-	.dst_hprot       ({cpu0_to_cache_hprot       , cpu0_to_tcm_hprot      }),
-	.dst_hmaster     ({cpu0_to_cache_hmaster     , cpu0_to_tcm_hmaster    }),
-	.dst_hmastlock   ({cpu0_to_cache_hmastlock   , cpu0_to_tcm_hmastlock  }),
-	.dst_hexcl       ({cpu0_to_cache_hexcl       , cpu0_to_tcm_hexcl      }),
-	.dst_hwdata      ({cpu0_to_cache_hwdata      , cpu0_to_tcm_hwdata     }),
-	.dst_hrdata      ({cpu0_to_cache_hrdata      , cpu0_to_tcm_hrdata     })
+	.dst_hready      ({cpu0_to_icache_hready      , cpu0_to_tcm_hready     }),
+	.dst_hready_resp ({cpu0_to_icache_hready_resp , cpu0_to_tcm_hready_resp}),
+	.dst_hresp       ({cpu0_to_icache_hresp       , cpu0_to_tcm_hresp      }),
+	.dst_hexokay     ({cpu0_to_icache_hexokay     , cpu0_to_tcm_hexokay    }),
+	.dst_haddr       ({cpu0_to_icache_haddr       , cpu0_to_tcm_haddr      }),
+	.dst_hwrite      ({cpu0_to_icache_hwrite      , cpu0_to_tcm_hwrite     }),
+	.dst_htrans      ({cpu0_to_icache_htrans      , cpu0_to_tcm_htrans     }),
+	.dst_hsize       ({cpu0_to_icache_hsize       , cpu0_to_tcm_hsize      }),
+	.dst_hburst      ({cpu0_to_icache_hburst      , cpu0_to_tcm_hburst     }),
+	.dst_hprot       ({cpu0_to_icache_hprot       , cpu0_to_tcm_hprot      }),
+	.dst_hmaster     ({cpu0_to_icache_hmaster     , cpu0_to_tcm_hmaster    }),
+	.dst_hmastlock   ({cpu0_to_icache_hmastlock   , cpu0_to_tcm_hmastlock  }),
+	.dst_hexcl       ({cpu0_to_icache_hexcl       , cpu0_to_tcm_hexcl      }),
+	.dst_hwdata      ({cpu0_to_icache_hwdata      , cpu0_to_tcm_hwdata     }),
+	.dst_hrdata      ({cpu0_to_icache_hrdata      , cpu0_to_tcm_hrdata     })
 );
 
 ahbl_splitter #(
@@ -707,26 +775,146 @@ ahbl_splitter #(
 	.src_hwdata      (cpu1_hwdata   ),
 	.src_hrdata      (cpu1_hrdata   ),
 
-	.dst_hready      ({cpu1_to_cache_hready      , cpu1_to_tcm_hready     }),
-	.dst_hready_resp ({cpu1_to_cache_hready_resp , cpu1_to_tcm_hready_resp}),
-	.dst_hresp       ({cpu1_to_cache_hresp       , cpu1_to_tcm_hresp      }),
-	.dst_hexokay     ({cpu1_to_cache_hexokay     , cpu1_to_tcm_hexokay    }),
-	.dst_haddr       ({cpu1_to_cache_haddr       , cpu1_to_tcm_haddr      }),
-	.dst_hwrite      ({cpu1_to_cache_hwrite      , cpu1_to_tcm_hwrite     }),
-	.dst_htrans      ({cpu1_to_cache_htrans      , cpu1_to_tcm_htrans     }),
-	.dst_hsize       ({cpu1_to_cache_hsize       , cpu1_to_tcm_hsize      }),
-	.dst_hburst      ({cpu1_to_cache_hburst      , cpu1_to_tcm_hburst     }),
-	.dst_hprot       ({cpu1_to_cache_hprot       , cpu1_to_tcm_hprot      }),
-	.dst_hmaster     ({cpu1_to_cache_hmaster     , cpu1_to_tcm_hmaster    }),
-	.dst_hmastlock   ({cpu1_to_cache_hmastlock   , cpu1_to_tcm_hmastlock  }),
-	.dst_hexcl       ({cpu1_to_cache_hexcl       , cpu1_to_tcm_hexcl      }),
-	.dst_hwdata      ({cpu1_to_cache_hwdata      , cpu1_to_tcm_hwdata     }),
-	.dst_hrdata      ({cpu1_to_cache_hrdata      , cpu1_to_tcm_hrdata     })
+	.dst_hready      ({cpu1_to_icache_hready      , cpu1_to_tcm_hready     }),
+	.dst_hready_resp ({cpu1_to_icache_hready_resp , cpu1_to_tcm_hready_resp}),
+	.dst_hresp       ({cpu1_to_icache_hresp       , cpu1_to_tcm_hresp      }),
+	.dst_hexokay     ({cpu1_to_icache_hexokay     , cpu1_to_tcm_hexokay    }),
+	.dst_haddr       ({cpu1_to_icache_haddr       , cpu1_to_tcm_haddr      }),
+	.dst_hwrite      ({cpu1_to_icache_hwrite      , cpu1_to_tcm_hwrite     }),
+	.dst_htrans      ({cpu1_to_icache_htrans      , cpu1_to_tcm_htrans     }),
+	.dst_hsize       ({cpu1_to_icache_hsize       , cpu1_to_tcm_hsize      }),
+	.dst_hburst      ({cpu1_to_icache_hburst      , cpu1_to_tcm_hburst     }),
+	.dst_hprot       ({cpu1_to_icache_hprot       , cpu1_to_tcm_hprot      }),
+	.dst_hmaster     ({cpu1_to_icache_hmaster     , cpu1_to_tcm_hmaster    }),
+	.dst_hmastlock   ({cpu1_to_icache_hmastlock   , cpu1_to_tcm_hmastlock  }),
+	.dst_hexcl       ({cpu1_to_icache_hexcl       , cpu1_to_tcm_hexcl      }),
+	.dst_hwdata      ({cpu1_to_icache_hwdata      , cpu1_to_tcm_hwdata     }),
+	.dst_hrdata      ({cpu1_to_icache_hrdata      , cpu1_to_tcm_hrdata     })
+);
+
+// Minimise cache address size to save tag memory size, routing etc. Need to
+// be able to address 64 MiB SDRAM, plus extra bit to select between SDRAM
+// and IO.
+localparam W_CACHE_ADDR = 27;
+
+wire [1:0] icache_invalidate;
+
+wire icache0_hit;
+wire icache0_miss;
+wire icache1_hit;
+wire icache1_miss;
+
+// Per-core instruction caches. Each core can run a hot loop out of its own
+// I-cache without using the shared cache port. Both snoop writes on the
+// shared bus, so newly-written code is picked up without explicit
+// invalidation.
+
+ahbl_icache #(
+	.W_ADDR     (W_ADDR),
+	.W_DATA     (W_DATA),
+	.SIZE_BYTES (ICACHE_SIZE_BYTES),
+	.W_REGION   (W_CACHE_ADDR)
+) cpu0_icache (
+	.clk             (clk_sys),
+	.rst_n           (rst_n_sys),
+
+	.src_hready      (cpu0_to_icache_hready),
+	.src_hready_resp (cpu0_to_icache_hready_resp),
+	.src_hresp       (cpu0_to_icache_hresp),
+	.src_hexokay     (cpu0_to_icache_hexokay),
+	.src_haddr       (cpu0_to_icache_haddr),
+	.src_hwrite      (cpu0_to_icache_hwrite),
+	.src_htrans      (cpu0_to_icache_htrans),
+	.src_hsize       (cpu0_to_icache_hsize),
+	.src_hburst      (cpu0_to_icache_hburst),
+	.src_hprot       (cpu0_to_icache_hprot),
+	.src_hmaster     (cpu0_to_icache_hmaster),
+	.src_hmastlock   (cpu0_to_icache_hmastlock),
+	.src_hexcl       (cpu0_to_icache_hexcl),
+	.src_hwdata      (cpu0_to_icache_hwdata),
+	.src_hrdata      (cpu0_to_icache_hrdata),
+
+	.dst_hready      (cpu0_to_cache_hready),
+	.dst_hready_resp (cpu0_to_cache_hready_resp),
+	.dst_hresp       (cpu0_to_cache_hresp),
+	.dst_hexokay     (cpu0_to_cache_hexokay),
+	.dst_haddr       (cpu0_to_cache_haddr),
+	.dst_hwrite      (cpu0_to_cache_hwrite),
+	.dst_htrans      (cpu0_to_cache_htrans),
+	.dst_hsize       (cpu0_to_cache_hsize),
+	.dst_hburst      (cpu0_to_cache_hburst),
+	.dst_hprot       (cpu0_to_cache_hprot),
+	.dst_hmaster     (cpu0_to_cache_hmaster),
+	.dst_hmastlock   (cpu0_to_cache_hmastlock),
+	.dst_hexcl       (cpu0_to_cache_hexcl),
+	.dst_hwdata      (cpu0_to_cache_hwdata),
+	.dst_hrdata      (cpu0_to_cache_hrdata),
+
+	.snoop_hready    (cache_src_hready),
+	.snoop_htrans    (cache_src_htrans),
+	.snoop_hwrite    (cache_src_hwrite),
+	.snoop_haddr     (cache_src_haddr),
+
+	.invalidate      (icache_invalidate[0]),
+
+	.stat_hit        (icache0_hit),
+	.stat_miss       (icache0_miss)
 );
 
+ahbl_icache #(
+	.W_ADDR     (W_ADDR),
+	.W_DATA     (W_DATA),
+	.SIZE_BYTES (ICACHE_SIZE_BYTES),
+	.W_REGION   (W_CACHE_ADDR)
+) cpu1_icache (
+	.clk             (clk_sys),
+	.rst_n           (rst_n_sys),
+
+	.src_hready      (cpu1_to_icache_hready),
+	.src_hready_resp (cpu1_to_icache_hready_resp),
+	.src_hresp       (cpu1_to_icache_hresp),
+	.src_hexokay     (cpu1_to_icache_hexokay),
+	.src_haddr       (cpu1_to_icache_haddr),
+	.src_hwrite      (cpu1_to_icache_hwrite),
+	.src_htrans      (cpu1_to_icache_htrans),
+	.src_hsize       (cpu1_to_icache_hsize),
+	.src_hburst      (cpu1_to_icache_hburst),
+	.src_hprot       (cpu1_to_icache_hprot),
+	.src_hmaster     (cpu1_to_icache_hmaster),
+	.src_hmastlock   (cpu1_to_icache_hmastlock),
+	.src_hexcl       (cpu1_to_icache_hexcl),
+	.src_hwdata      (cpu1_to_icache_hwdata),
+	.src_hrdata      (cpu1_to_icache_hrdata),
+
+	.dst_hready      (cpu1_to_cache_hready),
+	.dst_hready_resp (cpu1_to_cache_hready_resp),
+	.dst_hresp       (cpu1_to_cache_hresp),
+	.dst_hexokay     (cpu1_to_cache_hexokay),
+	.dst_haddr       (cpu1_to_cache_haddr),
+	.dst_hwrite      (cpu1_to_cache_hwrite),
+	.dst_htrans      (cpu1_to_cache_htrans),
+	.dst_hsize       (cpu1_to_cache_hsize),
+	.dst_hburst      (cpu1_to_cache_hburst),
+	.dst_hprot       (cpu1_to_cache_hprot),
+	.dst_hmaster     (cpu1_to_cache_hmaster),
+	.dst_hmastlock   (cpu1_to_cache_hmastlock),
+	.dst_hexcl       (cpu1_to_cache_hexcl),
+	.dst_hwdata      (cpu1_to_cache_hwdata),
+	.dst_hrdata      (cpu1_to_cache_hrdata),
+
+	.snoop_hready    (cache_src_hready),
+	.snoop_htrans    (cache_src_htrans),
+	.snoop_hwrite    (cache_src_hwrite),
+	.snoop_haddr     (cache_src_haddr),
+
+	.invalidate      (icache_invalidate[1]),
+
+	.stat_hit        (icache1_hit),
+	.stat_miss       (icache1_miss)
+);
 
 ahbl_arbiter #(
-	.N_PORTS          (2),
+	.N_PORTS          (3),
 	.W_ADDR           (W_ADDR),
 	.W_DATA           (W_DATA),
 	.FAIR_ARBITRATION (1)
@@ -734,21 +922,21 @@ ahbl_arbiter #(
 	.clk             (clk_sys),
 	.rst_n           (rst_n_sys),
 
-	.src_hready      ({cpu1_to_cache_hready      , cpu0_to_cache_hready     }),
-	.src_hready_resp ({cpu1_to_cache_hready_resp , cpu0_to_cache_hready_resp}),
-	.src_hresp       ({cpu1_to_cache_hresp       , cpu0_to_cache_hresp      }),
-	.src_hexokay     ({cpu1_to_cache_hexokay     , cpu0_to_cache_hexokay    }),
-	.src_haddr       ({cpu1_to_cache_haddr       , cpu0_to_cache_haddr      }),
-	.src_hwrite      ({cpu1_to_cache_hwrite      , cpu0_to_cache_hwrite     }),
-	.src_htrans      ({cpu1_to_cache_htrans      , cpu0_to_cache_htrans     }),
-	.src_hsize       ({cpu1_to_cache_hsize       , cpu0_to_cache_hsize      }),
-	.src_hburst      ({cpu1_to_cache_hburst      , cpu0_to_cache_hburst     }),
-	.src_hprot       ({cpu1_to_cache_hprot       , cpu0_to_cache_hprot      }),
-	.src_hmaster     ({cpu1_to_cache_hmaster     , cpu0_to_cache_hmaster    }),
-	.src_hmastlock   ({cpu1_to_cache_hmastlock   , cpu0_to_cache_hmastlock  }),
-	.src_hexcl       ({cpu1_to_cache_hexcl       , cpu0_to_cache_hexcl      }),
-	.src_hwdata      ({cpu1_to_cache_hwdata      , cpu0_to_cache_hwdata     }),
-	.src_hrdata      ({cpu1_to_cache_hrdata      , cpu0_to_cache_hrdata     }),
+	.src_hready      ({dma_hready    , cpu1_to_cache_hready      , cpu0_to_cache_hready     }),
+	.src_hready_resp ({dma_hready    , cpu1_to_cache_hready_resp , cpu0_to_cache_hready_resp}),
+	.src_hresp       ({dma_hresp     , cpu1_to_cache_hresp       , cpu0_to_cache_hresp      }),
+	.src_hexokay     ({dma_hexokay   , cpu1_to_cache_hexokay     , cpu0_to_cache_hexokay    }),
+	.src_haddr       ({dma_haddr     , cpu1_to_cache_haddr       , cpu0_to_cache_haddr      }),
+	.src_hwrite      ({dma_hwrite    , cpu1_to_cache_hwrite      , cpu0_to_cache_hwrite     }),
+	.src_htrans      ({dma_htrans    , cpu1_to_cache_htrans      , cpu0_to_cache_htrans     }),
+	.src_hsize       ({dma_hsize     , cpu1_to_cache_hsize       , cpu0_to_cache_hsize      }),
+	.src_hburst      ({dma_hburst    , cpu1_to_cache_hburst      , cpu0_to_cache_hburst     }),
+	.src_hprot       ({dma_hprot     , cpu1_to_cache_hprot       , cpu0_to_cache_hprot      }),
+	.src_hmaster     ({dma_hmaster   , cpu1_to_cache_hmaster     , cpu0_to_cache_hmaster    }),
+	.src_hmastlock   ({dma_hmastlock , cpu1_to_cache_hmastlock   , cpu0_to_cache_hmastlock  }),
+	.src_hexcl       ({dma_hexcl     , cpu1_to_cache_hexcl       , cpu0_to_cache_hexcl      }),
+	.src_hwdata      ({dma_hwdata    , cpu1_to_cache_hwdata      , cpu0_to_cache_hwdata     }),
+	.src_hrdata      ({dma_hrdata    , cpu1_to_cache_hrdata      , cpu0_to_cache_hrdata     }),
 
 	.dst_hready      (cache_src_hready     ),
 	.dst_hready_resp (cache_src_hready_resp),
@@ -855,15 +1043,38 @@ wire              cache_dst_hresp;
 wire [W_DATA-1:0] cache_dst_hwdata;
 wire [W_DATA-1:0] cache_dst_hrdata;
 
-// Minimise cache address size to save tag memory size, routing etc. Need to
-// be able to address 64 MiB SDRAM, plus extra bit to select between SDRAM
-// and IO.
-localparam W_CACHE_ADDR = 27;
-
 assign cache_dst_haddr[W_ADDR-1:W_CACHE_ADDR] = {W_ADDR-W_CACHE_ADDR{1'b0}};
 
+// Writes to the XIP window get an AHB error response here, and never reach
+// the cache. The flash can't be written through XIP, so a dirty XIP line
+// would only ever be written back to nothing, and XIP lines must stay clean
+// for cache maintenance to be able to just drop them.
+wire              cache_hready_resp;
+wire              cache_hresp;
+wire              cache_hexokay;
+
+wire xip_write_aph = cache_src_hready && cache_src_htrans[1] && cache_src_hwrite &&
+	cache_src_haddr[26:25] == 2'b11;
+
+reg xip_write_err1;
+reg xip_write_err2;
+
+always @ (posedge clk_sys or negedge rst_n_sys) begin
+	if (!rst_n_sys) begin
+		xip_write_err1 <= 1'b0;
+		xip_write_err2 <= 1'b0;
+	end else begin
+		xip_write_err1 <= xip_write_aph;
+		xip_write_err2 <= xip_write_err1;
+	end
+end
+
+assign cache_src_hready_resp = cache_hready_resp && !xip_write_err1;
+assign cache_src_hresp       = cache_hresp || xip_write_err1 || xip_write_err2;
+assign cache_src_hexokay     = cache_hexokay && !xip_write_err2;
+
 ahb_cache_writeback #(
-	.N_WAYS           (1                    ),
+	.N_WAYS           (CACHE_N_WAYS         ),
 	.W_ADDR           (W_CACHE_ADDR         ),
 	.W_DATA           (W_DATA               ),
 	.W_LINE           (128                  ), // 8-beat bursts on 16b SDRAM bus. Minimum efficient burst.
@@ -874,17 +1085,17 @@ ahb_cache_writeback #(
 	.clk             (clk_sys),
 	.rst_n           (rst_n_sys),
 
-	.src_hready_resp (cache_src_hready_resp),
+	.src_hready_resp (cache_hready_resp),
 	.src_hready      (cache_src_hready),
-	.src_hresp       (cache_src_hresp),
-	.src_hexokay     (cache_src_hexokay),
+	.src_hresp       (cache_hresp),
+	.src_hexokay     (cache_hexokay),
 	.src_haddr       (cache_src_haddr[W_CACHE_ADDR-1:0]),
 	.src_hwrite      (cache_src_hwrite),
-	.src_htrans      (cache_src_htrans),
+	.src_htrans      (xip_write_aph ? 2'b00 : cache_src_htrans),
 	.src_hsize       (cache_src_hsize),
 	.src_hburst      (cache_src_hburst),
-	// Map IO as noncacheable and SDRAM as cacheable:
-	.src_hprot       ({{2{!cache_src_haddr[26]}}, cache_src_hprot[1:0]}),
+	// Map IO as noncacheable, and SDRAM and XIP as cacheable:
+	.src_hprot       ({{2{!cache_src_haddr[26] || cache_src_haddr[25]}}, cache_src_hprot[1:0]}),
 	.src_hmaster     (cache_src_hmaster),
 	.src_hmastlock   (cache_src_hmastlock),
 	.src_hexcl       (cache_src_hexcl),
@@ -910,6 +1121,7 @@ ahb_cache_writeback #(
 
 // SDRAM     is at 32'h0800_0000
 // APB peri  is at 32'h0c00_0000
+// XIP       is at 32'h0e00_0000
 
 wire [W_ADDR-1:0] sdram_haddr;
 wire              sdram_hwrite;
@@ -937,12 +1149,25 @@ wire              peri_hresp;
 wire [W_DATA-1:0] peri_hwdata;
 wire [W_DATA-1:0] peri_hrdata;
 
+wire [W_ADDR-1:0] xip_haddr;
+wire              xip_hwrite;
+wire [1:0]        xip_htrans;
+wire [2:0]        xip_hsize;
+wire [2:0]        xip_hburst;
+wire [3:0]        xip_hprot;
+wire              xip_hmastlock;
+wire              xip_hready;
+wire              xip_hready_resp;
+wire              xip_hresp;
+wire [W_DATA-1:0] xip_hwdata;
+wire [W_DATA-1:0] xip_hrdata;
+
 ahbl_splitter #(
-	.N_PORTS     (2),
+	.N_PORTS     (3),
 	.W_ADDR      (W_ADDR),
 	.W_DATA      (W_DATA),
-	.ADDR_MAP    (64'h04000000_00000000),
-	.ADDR_MASK   (64'h04000000_04000000)
+	.ADDR_MAP    (96'h06000000_04000000_00000000),
+	.ADDR_MASK   (96'h06000000_06000000_04000000)
 ) split_cache (
 	.clk             (clk_sys       ),
 	.rst_n           (rst_n_sys     ),
@@ -960,18 +1185,18 @@ ahbl_splitter #(
 	.src_hwdata      (cache_dst_hwdata     ),
 	.src_hrdata      (cache_dst_hrdata     ),
 
-	.dst_hready      ({peri_hready      , sdram_hready     }),
-	.dst_hready_resp ({peri_hready_resp , sdram_hready_resp}),
-	.dst_hresp       ({peri_hresp       , sdram_hresp      }),
-	.dst_haddr       ({peri_haddr       , sdram_haddr      }),
-	.dst_hwrite      ({peri_hwrite      , sdram_hwrite     }),
-	.dst_htrans      ({peri_htrans      , sdram_htrans     }),
-	.dst_hsize       ({peri_hsize       , sdram_hsize      }),
-	.dst_hburst      ({peri_hburst      , sdram_hburst     }),
-	.dst_hprot       ({peri_hprot       , sdram_hprot      }),
-	.dst_hmastlock   ({peri_hmastlock   , sdram_hmastlock  }),
-	.dst_hwdata      ({peri_hwdata      , sdram_hwdata     }),
-	.dst_hrdata      ({peri_hrdata      , sdram_hrdata     })
+	.dst_hready      ({xip_hready      , peri_hready      , sdram_hready     }),
+	.dst_hready_resp ({xip_hready_resp , peri_hready_resp , sdram_hready_resp}),
+	.dst_hresp       ({xip_hresp       , peri_hresp       , sdram_hresp      }),
+	.dst_haddr       ({xip_haddr       , peri_haddr       , sdram_haddr      }),
+	.dst_hwrite      ({xip_hwrite      , peri_hwrite      , sdram_hwrite     }),
+	.dst_htrans      ({xip_htrans      , peri_htrans      , sdram_htrans     }),
+	.dst_hsize       ({xip_hsize       , peri_hsize       , sdram_hsize      }),
+	.dst_hburst      ({xip_hburst      , peri_hburst      , sdram_hburst     }),
+	.dst_hprot       ({xip_hprot       , peri_hprot       , sdram_hprot      }),
+	.dst_hmastlock   ({xip_hmastlock   , peri_hmastlock   , sdram_hmastlock  }),
+	.dst_hwdata      ({xip_hwdata      , peri_hwdata      , sdram_hwdata     }),
+	.dst_hrdata      ({xip_hrdata      , peri_hrdata      , sdram_hrdata     })
 );
 
 wire        peri_psel;
@@ -1022,6 +1247,10 @@ ahbl_to_apb #(
 // SDRAM cfg is at 32'h0c00_2000
 // Timer/IRQ is at 32'h0c00_3000
 // GPIO      is at 32'h0c00_4000
+// Perf ctrs is at 32'h0c00_5000
+// Cache ctrl is at 32'h0c00_6000
+// DMA       is at 32'h0c00_7000
+// XIP ctrl  is at 32'h0c00_8000
 
 wire        uart_psel;
 wire        uart_penable;
@@ -1068,12 +1297,48 @@ wire [31:0] gpio_prdata;
 wire        gpio_pready;
 wire        gpio_pslverr;
 
+wire        perf_psel;
+wire        perf_penable;
+wire        perf_pwrite;
+wire [15:0] perf_paddr;
+wire [31:0] perf_pwdata;
+wire [31:0] perf_prdata;
+wire        perf_pready;
+wire        perf_pslverr;
+
+wire        cachectrl_psel;
+wire        cachectrl_penable;
+wire        cachectrl_pwrite;
+wire [15:0] cachectrl_paddr;
+wire [31:0] cachectrl_pwdata;
+wire [31:0] cachectrl_prdata;
+wire        cachectrl_pready;
+wire        cachectrl_pslverr;
+
+wire        dma_psel;
+wire        dma_penable;
+wire        dma_pwrite;
+wire [15:0] dma_paddr;
+wire [31:0] dma_pwdata;
+wire [31:0] dma_prdata;
+wire        dma_pready;
+wire        dma_pslverr;
+
+wire        xip_psel;
+wire        xip_penable;
+wire        xip_pwrite;
+wire [15:0] xip_paddr;
+wire [31:0] xip_pwdata;
+wire [31:0] xip_prdata;
+wire        xip_pready;
+wire        xip_pslverr;
+
 apb_splitter #(
 	.W_ADDR    (16),
 	.W_DATA    (32),
-	.N_SLAVES  (5),
-	.ADDR_MAP  (80'h4000_3000_2000_1000_0000),
-	.ADDR_MASK (80'hf000_f000_f000_f000_f000)
+	.N_SLAVES  (9),
+	.ADDR_MAP  (144'h8000_7000_6000_5000_4000_3000_2000_1000_0000),
+	.ADDR_MASK (144'hf000_f000_f000_f000_f000_f000_f000_f000_f000)
 ) inst_apb_splitter (
 	.apbs_paddr   (peri_paddr  ),
 	.apbs_psel    (peri_psel   ),
@@ -1084,73 +1349,139 @@ apb_splitter #(
 	.apbs_prdata  (peri_prdata ),
 	.apbs_pslverr (peri_pslverr),
 
-	.apbm_paddr   ({gpio_paddr   , timer_paddr   , sdram_paddr   , spi0_paddr   , uart_paddr  }),
-	.apbm_psel    ({gpio_psel    , timer_psel    , sdram_psel    , spi0_psel    , uart_psel   }),
-	.apbm_penable ({gpio_penable , timer_penable , sdram_penable , spi0_penable , uart_penable}),
-	.apbm_pwrite  ({gpio_pwrite  , timer_pwrite  , sdram_pwrite  , spi0_pwrite  , uart_pwrite }),
-	.apbm_pwdata  ({gpio_pwdata  , timer_pwdata  , sdram_pwdata  , spi0_pwdata  , uart_pwdata }),
-	.apbm_pready  ({gpio_pready  , timer_pready  , sdram_pready  , spi0_pready  , uart_pready }),
-	.apbm_prdata  ({gpio_prdata  , timer_prdata  , sdram_prdata  , spi0_prdata  , uart_prdata }),
-	.apbm_pslverr ({gpio_pslverr , timer_pslverr , sdram_pslverr , spi0_pslverr , uart_pslverr})
+	.apbm_paddr   ({xip_paddr   , dma_paddr   , cachectrl_paddr   , perf_paddr   , gpio_paddr   , timer_paddr   , sdram_paddr   , spi0_paddr   , uart_paddr  }),
+	.apbm_psel    ({xip_psel    , dma_psel    , cachectrl_psel    , perf_psel    , gpio_psel    , timer_psel    , sdram_psel    , spi0_psel    , uart_psel   }),
+	.apbm_penable ({xip_penable , dma_penable , cachectrl_penable , perf_penable , gpio_penable , timer_penable , sdram_penable , spi0_penable , uart_penable}),
+	.apbm_pwrite  ({xip_pwrite  , dma_pwrite  , cachectrl_pwrite  , perf_pwrite  , gpio_pwrite  , timer_pwrite  , sdram_pwrite  , spi0_pwrite  , uart_pwrite }),
+	.apbm_pwdata  ({xip_pwdata  , dma_pwdata  , cachectrl_pwdata  , perf_pwdata  , gpio_pwdata  , timer_pwdata  , sdram_pwdata  , spi0_pwdata  , uart_pwdata }),
+	.apbm_pready  ({xip_pready  , dma_pready  , cachectrl_pready  , perf_pready  , gpio_pready  , timer_pready  , sdram_pready  , spi0_pready  , uart_pready }),
+	.apbm_prdata  ({xip_prdata  , dma_prdata  , cachectrl_prdata  , perf_prdata  , gpio_prdata  , timer_prdata  , sdram_prdata  , spi0_prdata  , uart_prdata }),
+	.apbm_pslverr ({xip_pslverr , dma_pslverr , cachectrl_pslverr , perf_pslverr , gpio_pslverr , timer_pslverr , sdram_pslverr , spi0_pslverr , uart_pslverr})
 );
 
 // ----------------------------------------------------------------------------
 // Peripherals
 
 wire uart_irq;
+wire dma_irq;
 
-ahbl_sdram #(
-	.COLUMN_BITS     (10),
-	.ROW_BITS        (13),
-	.W_SDRAM_BANKSEL (W_SDRAM_BANKSEL),
-	.W_SDRAM_ADDR    (W_SDRAM_ADDR),
-	.W_SDRAM_DATA    (W_SDRAM_DATA),
-	.N_MASTERS       (1),
-	.LEN_AHBL_BURST  (4),
-	.FIXED_TIMINGS   (0),
-	.W_HADDR         (W_ADDR),
-	.W_HDATA         (W_DATA)
-) sdram_u (
-	.clk               (clk_sys),
-	.rst_n             (rst_n_sys),
+wire spi0_mini_sclk;
+wire spi0_mini_sdo;
+wire spi0_mini_cs_n;
+wire xip_sclk;
+wire xip_sdo;
+wire xip_cs_n;
 
-	.phy_clk_enable    (sdram_phy_clk_enable),
-	.phy_ba_next       (sdram_phy_ba_next),
-	.phy_a_next        (sdram_phy_a_next),
-	.phy_dqm_next      (sdram_phy_dqm_next),
-
-	.phy_dq_o_next     (sdram_phy_dq_o_next),
-	.phy_dq_oe_next    (sdram_phy_dq_oe_next),
-	.phy_dq_i          (sdram_phy_dq_i),
-
-	.phy_clke_next     (sdram_phy_clke_next),
-	.phy_cs_n_next     (sdram_phy_cs_n_next),
-	.phy_ras_n_next    (sdram_phy_ras_n_next),
-	.phy_cas_n_next    (sdram_phy_cas_n_next),
-	.phy_we_n_next     (sdram_phy_we_n_next),
-
-	.apbs_psel         (sdram_psel),
-	.apbs_penable      (sdram_penable),
-	.apbs_pwrite       (sdram_pwrite),
-	.apbs_paddr        (sdram_paddr),
-	.apbs_pwdata       (sdram_pwdata),
-	.apbs_prdata       (sdram_prdata),
-	.apbs_pready       (sdram_pready),
-	.apbs_pslverr      (sdram_pslverr),
-
-	.ahbls_hready      (sdram_hready),
-	.ahbls_hready_resp (sdram_hready_resp),
-	.ahbls_hresp       (sdram_hresp),
-	.ahbls_haddr       (sdram_haddr),
-	.ahbls_hwrite      (sdram_hwrite),
-	.ahbls_htrans      (sdram_htrans),
-	.ahbls_hsize       (sdram_hsize),
-	.ahbls_hburst      (sdram_hburst),
-	.ahbls_hprot       (sdram_hprot),
-	.ahbls_hmastlock   (sdram_hmastlock),
-	.ahbls_hwdata      (sdram_hwdata),
-	.ahbls_hrdata      (sdram_hrdata)
-);
+generate
+if (SDRAM_CTRL == "LIBFPGA") begin
+
+	ahbl_sdram #(
+		.COLUMN_BITS     (10),
+		.ROW_BITS        (13),
+		.W_SDRAM_BANKSEL (W_SDRAM_BANKSEL),
+		.W_SDRAM_ADDR    (W_SDRAM_ADDR),
+		.W_SDRAM_DATA    (W_SDRAM_DATA),
+		.N_MASTERS       (1),
+		.LEN_AHBL_BURST  (4),
+		.FIXED_TIMINGS   (0),
+		.W_HADDR         (W_ADDR),
+		.W_HDATA         (W_DATA)
+	) sdram_u (
+		.clk               (clk_sys),
+		.rst_n             (rst_n_sys),
+
+		.phy_clk_enable    (sdram_phy_clk_enable),
+		.phy_ba_next       (sdram_phy_ba_next),
+		.phy_a_next        (sdram_phy_a_next),
+		.phy_dqm_next      (sdram_phy_dqm_next),
+
+		.phy_dq_o_next     (sdram_phy_dq_o_next),
+		.phy_dq_oe_next    (sdram_phy_dq_oe_next),
+		.phy_dq_i          (sdram_phy_dq_i),
+
+		.phy_clke_next     (sdram_phy_clke_next),
+		.phy_cs_n_next     (sdram_phy_cs_n_next),
+		.phy_ras_n_next    (sdram_phy_ras_n_next),
+		.phy_cas_n_next    (sdram_phy_cas_n_next),
+		.phy_we_n_next     (sdram_phy_we_n_next),
+
+		.apbs_psel         (sdram_psel),
+		.apbs_penable      (sdram_penable),
+		.apbs_pwrite       (sdram_pwrite),
+		.apbs_paddr        (sdram_paddr),
+		.apbs_pwdata       (sdram_pwdata),
+		.apbs_prdata       (sdram_prdata),
+		.apbs_pready       (sdram_pready),
+		.apbs_pslverr      (sdram_pslverr),
+
+		.ahbls_hready      (sdram_hready),
+		.ahbls_hready_resp (sdram_hready_resp),
+		.ahbls_hresp       (sdram_hresp),
+		.ahbls_haddr       (sdram_haddr),
+		.ahbls_hwrite      (sdram_hwrite),
+		.ahbls_htrans      (sdram_htrans),
+		.ahbls_hsize       (sdram_hsize),
+		.ahbls_hburst      (sdram_hburst),
+		.ahbls_hprot       (sdram_hprot),
+		.ahbls_hmastlock   (sdram_hmastlock),
+		.ahbls_hwdata      (sdram_hwdata),
+		.ahbls_hrdata      (sdram_hrdata)
+	);
+
+end else if (SDRAM_CTRL == "OPEN_PAGE") begin
+
+	ahbl_sdram_openpage #(
+		.COLUMN_BITS     (10),
+		.ROW_BITS        (13),
+		.W_SDRAM_BANKSEL (W_SDRAM_BANKSEL),
+		.W_SDRAM_ADDR    (W_SDRAM_ADDR),
+		.W_SDRAM_DATA    (W_SDRAM_DATA),
+		.W_HADDR         (W_ADDR),
+		.W_HDATA         (W_DATA)
+	) sdram_u (
+		.clk               (clk_sys),
+		.rst_n             (rst_n_sys),
+
+		.phy_clk_enable    (sdram_phy_clk_enable),
+		.phy_ba_next       (sdram_phy_ba_next),
+		.phy_a_next        (sdram_phy_a_next),
+		.phy_dqm_next      (sdram_phy_dqm_next),
+
+		.phy_dq_o_next     (sdram_phy_dq_o_next),
+		.phy_dq_oe_next    (sdram_phy_dq_oe_next),
+		.phy_dq_i          (sdram_phy_dq_i),
+
+		.phy_clke_next     (sdram_phy_clke_next),
+		.phy_cs_n_next     (sdram_phy_cs_n_next),
+		.phy_ras_n_next    (sdram_phy_ras_n_next),
+		.phy_cas_n_next    (sdram_phy_cas_n_next),
+		.phy_we_n_next     (sdram_phy_we_n_next),
+
+		.apbs_psel         (sdram_psel),
+		.apbs_penable      (sdram_penable),
+		.apbs_pwrite       (sdram_pwrite),
+		.apbs_paddr        (sdram_paddr),
+		.apbs_pwdata       (sdram_pwdata),
+		.apbs_prdata       (sdram_prdata),
+		.apbs_pready       (sdram_pready),
+		.apbs_pslverr      (sdram_pslverr),
+
+		.ahbls_hready      (sdram_hready),
+		.ahbls_hready_resp (sdram_hready_resp),
+		.ahbls_hresp       (sdram_hresp),
+		.ahbls_haddr       (sdram_haddr),
+		.ahbls_hwrite      (sdram_hwrite),
+		.ahbls_htrans      (sdram_htrans),
+		.ahbls_hsize       (sdram_hsize),
+		.ahbls_hburst      (sdram_hburst),
+		.ahbls_hprot       (sdram_hprot),
+		.ahbls_hmastlock   (sdram_hmastlock),
+		.ahbls_hwdata      (sdram_hwdata),
+		.ahbls_hrdata      (sdram_hrdata)
+	);
+
+end
+endgenerate
 
 uart_mini uart_u (
 	.clk          (clk_sys),
@@ -1193,7 +1524,7 @@ platform_timer timer_u (
 );
 
 spi_mini #(
-	.FIFO_DEPTH (2)
+	.FIFO_DEPTH (8) // Must match SPI_FIFO_DEPTH in spi.h
 ) spi0_u (
 	.clk          (clk_sys),
 	.rst_n        (rst_n_sys),
@@ -1207,12 +1538,118 @@ spi_mini #(
 	.apbs_pready  (spi0_pready),
 	.apbs_pslverr (spi0_pslverr),
 
-	.sclk         (spi0_sclk),
-	.sdo          (spi0_sdo),
+	.sclk         (spi0_mini_sclk),
+	.sdo          (spi0_mini_sdo),
 	.sdi          (spi0_sdi),
-	.cs_n         (spi0_cs_n)
+	.cs_n         (spi0_mini_cs_n)
+);
+
+// spi_mini and the XIP controller share the flash pins, and spi_mini has them
+// whenever its chip select is asserted. An XIP transfer that starts while
+// spi_mini has chip select is held here, with hready low, and passed on to
+// the XIP controller once spi_mini deselects the flash. Only the first beat
+// of a burst is held: software must still not assert spi_mini chip select
+// part-way through an XIP line fill, e.g. from another core.
+wire              xip_ctrl_hready;
+wire              xip_ctrl_hready_resp;
+wire              xip_ctrl_hresp;
+wire [W_ADDR-1:0] xip_ctrl_haddr;
+wire              xip_ctrl_hwrite;
+wire [1:0]        xip_ctrl_htrans;
+wire [2:0]        xip_ctrl_hsize;
+wire [2:0]        xip_ctrl_hburst;
+wire [3:0]        xip_ctrl_hprot;
+wire              xip_ctrl_hmastlock;
+
+wire xip_blocked = !spi0_mini_cs_n;
+wire xip_hold_aph = xip_hready && xip_htrans == 2'b10 && xip_blocked;
+
+reg              xip_held;
+reg [W_ADDR-1:0] xip_held_haddr;
+reg              xip_held_hwrite;
+reg [2:0]        xip_held_hsize;
+reg [2:0]        xip_held_hburst;
+reg [3:0]        xip_held_hprot;
+reg              xip_held_hmastlock;
+
+wire xip_replay = xip_held && !xip_blocked;
+
+always @ (posedge clk_sys or negedge rst_n_sys) begin
+	if (!rst_n_sys) begin
+		xip_held <= 1'b0;
+		xip_held_haddr <= {W_ADDR{1'b0}};
+		xip_held_hwrite <= 1'b0;
+		xip_held_hsize <= 3'h0;
+		xip_held_hburst <= 3'h0;
+		xip_held_hprot <= 4'h0;
+		xip_held_hmastlock <= 1'b0;
+	end else if (xip_hold_aph) begin
+		xip_held <= 1'b1;
+		xip_held_haddr <= xip_haddr;
+		xip_held_hwrite <= xip_hwrite;
+		xip_held_hsize <= xip_hsize;
+		xip_held_hburst <= xip_hburst;
+		xip_held_hprot <= xip_hprot;
+		xip_held_hmastlock <= xip_hmastlock;
+	end else if (xip_replay) begin
+		xip_held <= 1'b0;
+	end
+end
+
+// While held, the XIP controller is idle, and the held transfer's data phase
+// is stalled on the bus. The cycle it is replayed is still stalled, then the
+// XIP controller's data phase response is passed through as normal.
+assign xip_ctrl_hready    = xip_held ? 1'b1 : xip_hready;
+assign xip_ctrl_htrans    = xip_replay ? 2'b10 : xip_held || xip_hold_aph ? 2'b00 : xip_htrans;
+assign xip_ctrl_haddr     = xip_held ? xip_held_haddr     : xip_haddr;
+assign xip_ctrl_hwrite    = xip_held ? xip_held_hwrite    : xip_hwrite;
+assign xip_ctrl_hsize     = xip_held ? xip_held_hsize     : xip_hsize;
+assign xip_ctrl_hburst    = xip_held ? xip_held_hburst    : xip_hburst;
+assign xip_ctrl_hprot     = xip_held ? xip_held_hprot     : xip_hprot;
+assign xip_ctrl_hmastlock = xip_held ? xip_held_hmastlock : xip_hmastlock;
+
+assign xip_hready_resp = xip_ctrl_hready_resp && !xip_held;
+assign xip_hresp       = xip_ctrl_hresp && !xip_held;
+
+spi_03h_xip #(
+	.W_ADDR (W_ADDR),
+	.W_DATA (W_DATA)
+) xip_u (
+	.clk               (clk_sys),
+	.rst_n             (rst_n_sys),
+
+	.apbs_psel         (xip_psel),
+	.apbs_penable      (xip_penable),
+	.apbs_pwrite       (xip_pwrite),
+	.apbs_paddr        (xip_paddr),
+	.apbs_pwdata       (xip_pwdata),
+	.apbs_prdata       (xip_prdata),
+	.apbs_pready       (xip_pready),
+	.apbs_pslverr      (xip_pslverr),
+
+	.ahbls_hready      (xip_ctrl_hready),
+	.ahbls_hready_resp (xip_ctrl_hready_resp),
+	.ahbls_hresp       (xip_ctrl_hresp),
+	.ahbls_haddr       (xip_ctrl_haddr),
+	.ahbls_hwrite      (xip_ctrl_hwrite),
+	.ahbls_htrans      (xip_ctrl_htrans),
+	.ahbls_hsize       (xip_ctrl_hsize),
+	.ahbls_hburst      (xip_ctrl_hburst),
+	.ahbls_hprot       (xip_ctrl_hprot),
+	.ahbls_hmastlock   (xip_ctrl_hmastlock),
+	.ahbls_hwdata      (xip_hwdata),
+	.ahbls_hrdata      (xip_hrdata),
+
+	.spi_cs_n          (xip_cs_n),
+	.spi_sclk          (xip_sclk),
+	.spi_mosi          (xip_sdo),
+	.spi_miso          (spi0_sdi)
 );
 
+assign spi0_cs_n = spi0_mini_cs_n && xip_cs_n;
+assign spi0_sclk = spi0_mini_cs_n ? xip_sclk : spi0_mini_sclk;
+assign spi0_sdo  = spi0_mini_cs_n ? xip_sdo  : spi0_mini_sdo;
+
 gpio #(
 	.N_GPIOS (N_GPIOS)
 ) gpio_u (
@@ -1233,7 +1670,134 @@ gpio #(
 	.i            (gpio_i)
 );
 
-assign irq = {31'h0, uart_irq};
+// Line fills from the last 64K of SDRAM, which software keeps free for
+// evicting lines from the shared cache (CACHE_EVICT_BASE in cache.h)
+wire cache_evict_fill = cache_dst_hready && cache_dst_htrans == 2'b10 &&
+	!cache_dst_hwrite && cache_dst_haddr[W_CACHE_ADDR-1:16] == 11'h3ff;
+
+cache_ctrl #(
+	.CACHE_SIZE_BYTES (CACHE_SIZE_BYTES),
+	.CACHE_N_WAYS     (CACHE_N_WAYS),
+	.CACHE_LINE_BYTES (16)
+) cachectrl_u (
+	.clk               (clk_sys),
+	.rst_n             (rst_n_sys),
+
+	.apbs_psel         (cachectrl_psel),
+	.apbs_penable      (cachectrl_penable),
+	.apbs_pwrite       (cachectrl_pwrite),
+	.apbs_paddr        (cachectrl_paddr),
+	.apbs_pwdata       (cachectrl_pwdata),
+	.apbs_prdata       (cachectrl_prdata),
+	.apbs_pready       (cachectrl_pready),
+	.apbs_pslverr      (cachectrl_pslverr),
+
+	.evict_fill        (cache_evict_fill),
+	.icache_invalidate (icache_invalidate)
+);
+
+dma dma_u (
+	.clk             (clk_sys),
+	.rst_n           (rst_n_sys),
+
+	.apbs_psel       (dma_psel),
+	.apbs_penable    (dma_penable),
+	.apbs_pwrite     (dma_pwrite),
+	.apbs_paddr      (dma_paddr),
+	.apbs_pwdata     (dma_pwdata),
+	.apbs_prdata     (dma_prdata),
+	.apbs_pready     (dma_pready),
+	.apbs_pslverr    (dma_pslverr),
+
+	.ahblm_hready    (dma_hready),
+	.ahblm_hresp     (dma_hresp),
+	.ahblm_haddr     (dma_haddr),
+	.ahblm_hwrite    (dma_hwrite),
+	.ahblm_htrans    (dma_htrans),
+	.ahblm_hsize     (dma_hsize),
+	.ahblm_hburst    (dma_hburst),
+	.ahblm_hprot     (dma_hprot),
+	.ahblm_hmastlock (dma_hmastlock),
+	.ahblm_hwdata    (dma_hwdata),
+	.ahblm_hrdata    (dma_hrdata),
+
+	.irq             (dma_irq)
+);
+
+// ----------------------------------------------------------------------------
+// Performance counter events
+
+// The cache port of each core stalls either because the shared cache is
+// busy with that core's own transfer (e.g. a miss), or because the arbiter
+// has given the cache to another master. Track whose transfer the cache is
+// currently working on, to tell these apart.
+
+reg       cache_dph_active;
+reg [1:0] cache_dph_master;
+
+always @ (posedge clk_sys or negedge rst_n_sys) begin
+	if (!rst_n_sys) begin
+		cache_dph_active <= 1'b0;
+		cache_dph_master <= 2'h0;
+	end else if (cache_src_hready) begin
+		cache_dph_active <= cache_src_htrans[1];
+		cache_dph_master <= cache_src_hmaster[1:0];
+	end
+end
+
+wire cache_src_aphase = cache_src_hready && cache_src_htrans[1] &&
+	!cache_src_haddr[W_CACHE_ADDR-1];
+wire cache_dst_aphase = cache_dst_hready && cache_dst_htrans == 2'b10 &&
+	!cache_dst_haddr[W_CACHE_ADDR-1];
+
+wire sdram_cmd = !sdram_phy_cs_n_next && !sdram_phy_ras_n_next;
+wire sdram_cmd_refresh = sdram_cmd && !sdram_phy_cas_n_next && sdram_phy_we_n_next;
+wire sdram_cmd_activate = sdram_cmd && sdram_phy_cas_n_next && sdram_phy_we_n_next;
+
+wire cpu0_arb_stall = !cpu0_to_cache_hready_resp && !(cache_dph_active && cache_dph_master == 2'h0);
+wire cpu1_arb_stall = !cpu1_to_cache_hready_resp && !(cache_dph_active && cache_dph_master == 2'h1);
+
+// Event numbers are listed in perf.h, and must match.
+wire [31:0] perf_events = {
+	13'h0,
+	cache_src_aphase && cache_src_hmaster == 8'h02, // 18
+	icache1_miss,                                   // 17
+	icache1_hit,                                    // 16
+	icache0_miss,                                   // 15
+	icache0_hit,                                    // 14
+	sdram_cmd_refresh,                              // 13
+	sdram_cmd_activate,                             // 12
+	!sdram_hready_resp,                             // 11
+	cpu1_arb_stall,                                 // 10
+	cpu0_arb_stall,                                 // 9
+	!cpu1_to_cache_hready_resp,                     // 8
+	!cpu0_to_cache_hready_resp,                     // 7
+	cache_src_aphase && cache_src_hmaster == 8'h01, // 6
+	cache_src_aphase && cache_src_hmaster == 8'h00, // 5
+	cache_dst_aphase && cache_dst_hwrite,           // 4
+	cache_dst_aphase && !cache_dst_hwrite,          // 3
+	cache_src_aphase,                               // 2
+	1'b1,                                           // 1
+	1'b0                                            // 0
+};
+
+perf_counters perf_u (
+	.clk          (clk_sys),
+	.rst_n        (rst_n_sys),
+
+	.apbs_psel    (perf_psel),
+	.apbs_penable (perf_penable),
+	.apbs_pwrite  (perf_pwrite),
+	.apbs_paddr   (perf_paddr),
+	.apbs_pwdata  (perf_pwdata),
+	.apbs_prdata  (perf_prdata),
+	.apbs_pready  (perf_pready),
+	.apbs_pslverr (perf_pslverr),
+
+	.events       (perf_events)
+);
+
+assign irq = {30'h0, dma_irq, uart_irq};
 
 endmodule
 
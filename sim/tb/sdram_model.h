@@ -0,0 +1,552 @@
+#ifndef _SDRAM_MODEL_H
+#define _SDRAM_MODEL_H
+
+// Behavioural model of one x16 SDR SDRAM, attached to the SDRAM pins of tb.v
+// and evaluated once per SDRAM clock (the SDRAM clock is the inverse of
+// clk_sys, so this is clk_sys negedge).
+//
+// Supports Activate, Read, Write (with DQM byte masking), Precharge, Burst
+// Terminate, Auto Refresh and Load Mode Register. The mode register sets
+// burst length (1/2/4/8/full page), burst type (sequential/interleaved),
+// CAS latency and single-location write bursts. Data timing matches the old
+// sdram_model.v, i.e. read data appears on the DQ outputs CAS latency - 1
+// calls after the Read command.
+//
+// The full array is backed, but storage is only allocated for pages which
+// have been written: unwritten locations read as zero. With no command on
+// the bus and no burst in flight a call returns almost immediately.
+//
+// Optionally, every command is checked against the timings programmed into
+// the controller (SDRAMTiming), and against the bank state, e.g. no Read
+// to a bank with no open row. Violations are reported on stderr. Usage
+// statistics (row hit rate, refresh overhead, bandwidth) are always kept,
+// since they cost nothing on idle cycles.
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cstdarg>
+#include <memory>
+#include <vector>
+#include <istream>
+#include <ostream>
+
+// Controller timing parameters, in SDRAM clock cycles
+struct SDRAMTiming {
+	int rc;   // Activate to Activate, same bank. Also used for tRFC.
+	int rcd;  // Activate to Read/Write
+	int rp;   // Precharge to Activate/Refresh
+	int rrd;  // Activate to Activate, different banks
+	int ras;  // Activate to Precharge
+	int wr;   // Last write data to Precharge
+	int cas;  // CAS latency
+	int refi; // Average refresh interval
+
+	// Decode values as written to the controller's TIME and REFRESH
+	// registers. TIME fields hold the cycle count minus one.
+	static SDRAMTiming from_regs(uint32_t time, uint32_t refresh) {
+		SDRAMTiming t;
+		t.rc   = (time >> 0 & 0x7u) + 1;
+		t.rcd  = (time >> 4 & 0x7u) + 1;
+		t.rp   = (time >> 8 & 0x7u) + 1;
+		t.rrd  = (time >> 12 & 0x7u) + 1;
+		t.ras  = (time >> 16 & 0x7u) + 1;
+		t.wr   = (time >> 20 & 0x7u) + 1;
+		t.cas  = (time >> 24 & 0x3u) + 1;
+		t.refi = refresh & 0xfffu;
+		return t;
+	}
+};
+
+struct SDRAMStats {
+	uint64_t n_activate;
+	uint64_t n_read;
+	uint64_t n_write;
+	uint64_t n_precharge;
+	uint64_t n_refresh;
+	uint64_t n_row_hit;      // Read/Write to a row already accessed since it was opened
+	uint64_t n_row_miss;     // First Read/Write after Activate
+	uint64_t n_row_reopen;   // Activate of the same row the bank last had open
+	uint64_t n_row_conflict; // Activate of a different row from the bank's last one
+	uint64_t beats_read;
+	uint64_t beats_written;
+	uint64_t n_violations;
+};
+
+class SDRAMModel {
+
+	static const int PAGE_WORDS = 2048; // 4 KiB of 16-bit words
+	static const int MAX_CAS_LATENCY = 3;
+	static const int MAX_VIOLATION_MESSAGES = 20;
+	// JEDEC allows up to 8 refreshes to be postponed
+	static const int MAX_REFRESH_POSTPONE = 8;
+	static const int64_t NEVER = INT64_MIN / 2;
+
+	enum cmd_t {
+		CMD_LOAD_MODE  = 0x0,
+		CMD_REFRESH    = 0x1,
+		CMD_PRECHARGE  = 0x2,
+		CMD_ACTIVATE   = 0x3,
+		CMD_WRITE      = 0x4,
+		CMD_READ       = 0x5,
+		CMD_BURST_TERM = 0x6,
+		CMD_NOP        = 0x7
+	};
+
+	int row_bits;
+	int bank_bits;
+	int col_bits;
+
+	std::vector<std::unique_ptr<uint16_t[]>> pages;
+
+	// Mode register state
+	int burst_len;
+	bool burst_interleave;
+	int cas_latency;
+	bool write_burst_single;
+
+	std::vector<uint32_t> bank_row;
+
+	// Burst in progress
+	int burst_left;
+	int burst_ctr;
+	bool burst_is_write;
+	bool burst_auto_precharge;
+	uint32_t burst_bank;
+	uint32_t burst_col;
+
+	// Bank state and command history, for checking and statistics
+	struct bank_t {
+		bool active;
+		bool accessed;
+		bool opened;
+		uint32_t row;
+		int64_t t_activate;
+		int64_t t_precharge;
+		int64_t t_write;
+	};
+	std::vector<bank_t> banks;
+	int64_t t_activate_any;
+	uint32_t bank_activate_any;
+	int64_t t_refresh;
+	bool check_en;
+	bool cas_checked;
+	SDRAMTiming timing;
+	SDRAMStats stats;
+
+	// Read data pipeline, indexed by call count
+	uint16_t rdata_pipe[MAX_CAS_LATENCY];
+	int pipe_busy;
+	uint32_t pipe_ptr;
+	uint16_t dq_out;
+
+	uint32_t word_index(uint32_t bank, uint32_t row, uint32_t col) const {
+		return (row << (bank_bits + col_bits)) | (bank << col_bits) | col;
+	}
+
+	uint16_t *word_ptr(uint32_t index, bool alloc) {
+		std::unique_ptr<uint16_t[]> &page = pages[index / PAGE_WORDS];
+		if (!page) {
+			if (!alloc)
+				return NULL;
+			page.reset(new uint16_t[PAGE_WORDS]);
+			memset(page.get(), 0, PAGE_WORDS * sizeof(uint16_t));
+		}
+		return &page[index % PAGE_WORDS];
+	}
+
+	void load_mode(uint32_t a) {
+		switch (a & 0x7u) {
+		case 0: burst_len = 1; break;
+		case 1: burst_len = 2; break;
+		case 2: burst_len = 4; break;
+		case 3: burst_len = 8; break;
+		default: burst_len = 1 << col_bits; break;
+		}
+		burst_interleave = (a >> 3) & 0x1u;
+		cas_latency = (a >> 4) & 0x7u;
+		if (cas_latency < 1 || cas_latency > MAX_CAS_LATENCY)
+			cas_latency = 2;
+		write_burst_single = (a >> 9) & 0x1u;
+	}
+
+	// Column of the current beat. Bursts wrap within a burst-aligned block.
+	uint32_t beat_col() const {
+		uint32_t mask = burst_len - 1;
+		uint32_t offs = burst_interleave ? burst_col ^ burst_ctr : burst_col + burst_ctr;
+		return (burst_col & ~mask) | (offs & mask);
+	}
+
+	void do_beat(int64_t cycle, uint8_t dqm, uint16_t dq_in, uint16_t &rdata) {
+		uint32_t index = word_index(burst_bank, bank_row[burst_bank], beat_col());
+		if (burst_is_write) {
+			banks[burst_bank].t_write = cycle;
+			++stats.beats_written;
+			if ((dqm & 0x3u) != 0x3u) {
+				uint16_t *w = word_ptr(index, true);
+				uint16_t keep = (dqm & 0x1u ? 0x00ffu : 0) | (dqm & 0x2u ? 0xff00u : 0);
+				*w = (*w & keep) | (dq_in & ~keep);
+			}
+		}
+		else {
+			const uint16_t *w = word_ptr(index, false);
+			rdata = w ? *w : 0;
+			++stats.beats_read;
+		}
+		++burst_ctr;
+		--burst_left;
+		// Auto precharge starts after the last read beat, or tWR after the
+		// last write beat
+		if (!burst_left && burst_auto_precharge) {
+			banks[burst_bank].active = false;
+			banks[burst_bank].t_precharge = cycle + (burst_is_write ? timing.wr : 0);
+		}
+	}
+
+	void violation(int64_t cycle, const char *fmt, ...) {
+		++stats.n_violations;
+		if (stats.n_violations > MAX_VIOLATION_MESSAGES)
+			return;
+		va_list args;
+		va_start(args, fmt);
+		fprintf(stderr, "SDRAM violation at cycle %ld: ", (long)cycle);
+		vfprintf(stderr, fmt, args);
+		fprintf(stderr, "\n");
+		if (stats.n_violations == MAX_VIOLATION_MESSAGES)
+			fprintf(stderr, "(Further SDRAM violations not shown)\n");
+		va_end(args);
+	}
+
+	void check_time(int64_t cycle, const char *param, int64_t since, int need, int bank = -1) {
+		if (!check_en || cycle - since >= need)
+			return;
+		if (bank >= 0)
+			violation(cycle, "%s on bank %d: %ld cycles, need %d", param, bank, (long)(cycle - since), need);
+		else
+			violation(cycle, "%s: %ld cycles, need %d", param, (long)(cycle - since), need);
+	}
+
+	void track_command(int64_t cycle, cmd_t cmd, uint32_t ba, uint32_t a) {
+		bank_t &bank = banks[ba];
+		switch (cmd) {
+		case CMD_ACTIVATE: {
+			uint32_t row = a & ((1u << row_bits) - 1);
+			if (check_en && bank.active)
+				violation(cycle, "Activate on bank %u, which already has row %u open", ba, bank.row);
+			check_time(cycle, "tRC", bank.t_activate, timing.rc, ba);
+			check_time(cycle, "tRP", bank.t_precharge, timing.rp, ba);
+			check_time(cycle, "tRFC", t_refresh, timing.rc, ba);
+			if (bank_activate_any != ba)
+				check_time(cycle, "tRRD", t_activate_any, timing.rrd, ba);
+			++stats.n_activate;
+			if (bank.opened && bank.row == row)
+				++stats.n_row_reopen;
+			else if (bank.opened)
+				++stats.n_row_conflict;
+			bank.active = true;
+			bank.accessed = false;
+			bank.opened = true;
+			bank.row = row;
+			bank.t_activate = cycle;
+			t_activate_any = cycle;
+			bank_activate_any = ba;
+			break;
+		}
+		case CMD_READ:
+		case CMD_WRITE:
+			if (check_en && !bank.active)
+				violation(cycle, "%s on bank %u, which has no open row", cmd == CMD_READ ? "Read" : "Write", ba);
+			check_time(cycle, "tRCD", bank.t_activate, timing.rcd, ba);
+			if (check_en && cmd == CMD_READ && !cas_checked && timing.cas != cas_latency) {
+				violation(cycle, "controller CAS latency is %d, mode register CAS latency is %d",
+					timing.cas, cas_latency);
+				cas_checked = true;
+			}
+			++(cmd == CMD_READ ? stats.n_read : stats.n_write);
+			++(bank.accessed ? stats.n_row_hit : stats.n_row_miss);
+			bank.accessed = true;
+			break;
+		case CMD_PRECHARGE:
+			++stats.n_precharge;
+			for (uint32_t i = 0; i < banks.size(); ++i) {
+				if (!(i == ba || a & 0x400u) || !banks[i].active)
+					continue;
+				check_time(cycle, "tRAS", banks[i].t_activate, timing.ras, i);
+				check_time(cycle, "tWR", banks[i].t_write, timing.wr, i);
+				banks[i].active = false;
+				banks[i].t_precharge = cycle;
+			}
+			break;
+		case CMD_REFRESH:
+			for (uint32_t i = 0; i < banks.size(); ++i) {
+				if (check_en && banks[i].active)
+					violation(cycle, "Refresh whilst bank %u has row %u open", i, banks[i].row);
+				check_time(cycle, "tRP", banks[i].t_precharge, timing.rp, i);
+			}
+			check_time(cycle, "tRFC", t_refresh, timing.rc);
+			if (check_en && t_refresh != NEVER && timing.refi &&
+				cycle - t_refresh > (int64_t)timing.refi * (MAX_REFRESH_POSTPONE + 1)) {
+				violation(cycle, "%ld cycles since last refresh, tREFI is %d",
+					(long)(cycle - t_refresh), timing.refi);
+			}
+			++stats.n_refresh;
+			t_refresh = cycle;
+			break;
+		case CMD_LOAD_MODE:
+			for (uint32_t i = 0; i < banks.size(); ++i)
+				if (check_en && banks[i].active)
+					violation(cycle, "Load Mode Register whilst bank %u has row %u open", i, banks[i].row);
+			break;
+		default:
+			break;
+		}
+	}
+
+public:
+
+	SDRAMModel(int row_bits_ = 13, int bank_bits_ = 2, int col_bits_ = 10) {
+		row_bits = row_bits_;
+		bank_bits = bank_bits_;
+		col_bits = col_bits_;
+		pages.resize(((size_t)1 << (row_bits + bank_bits + col_bits)) / PAGE_WORDS);
+		bank_row.resize(1u << bank_bits);
+		banks.resize(1u << bank_bits);
+		for (auto &b : banks) {
+			b.active = false;
+			b.accessed = false;
+			b.opened = false;
+			b.row = 0;
+			b.t_activate = NEVER;
+			b.t_precharge = NEVER;
+			b.t_write = NEVER;
+		}
+		t_activate_any = NEVER;
+		bank_activate_any = 0;
+		t_refresh = NEVER;
+		check_en = false;
+		cas_checked = false;
+		timing = SDRAMTiming::from_regs(0, 0);
+		memset(&stats, 0, sizeof(stats));
+		// Power-on defaults match the old RTL model's parameters, in case
+		// something skips the mode register write.
+		burst_len = 8;
+		burst_interleave = false;
+		cas_latency = 2;
+		write_burst_single = false;
+		burst_left = 0;
+		burst_ctr = 0;
+		burst_is_write = false;
+		burst_auto_precharge = false;
+		burst_bank = 0;
+		burst_col = 0;
+		memset(rdata_pipe, 0, sizeof(rdata_pipe));
+		pipe_busy = 0;
+		pipe_ptr = 0;
+		dq_out = 0;
+	}
+
+	// Timings the controller is programmed with. Used for checking, and for
+	// estimating cycle costs in the statistics.
+	void set_timing(const SDRAMTiming &t) {
+		timing = t;
+	}
+
+	// Check each command against the timings from now on
+	void enable_checks() {
+		check_en = true;
+	}
+
+	const SDRAMStats &get_stats() const {
+		return stats;
+	}
+
+	void report_stats(FILE *f, int64_t cycles, double clk_hz) const {
+		uint64_t accesses = stats.n_read + stats.n_write;
+		uint64_t beats = stats.beats_read + stats.beats_written;
+		uint64_t misses_cold = stats.n_activate - stats.n_row_reopen - stats.n_row_conflict;
+		uint64_t refresh_cycles = stats.n_refresh * timing.rc;
+		// A controller which left rows open would have hit on these instead of
+		// paying a Precharge and an Activate
+		uint64_t reopen_cycles = stats.n_row_reopen * (timing.rp + timing.rcd);
+		double secs = cycles / clk_hz;
+		fprintf(f, "SDRAM statistics over %ld cycles:\n", (long)cycles);
+		fprintf(f, "  Commands:   %lu activate, %lu read, %lu write, %lu precharge, %lu refresh\n",
+			(unsigned long)stats.n_activate, (unsigned long)stats.n_read, (unsigned long)stats.n_write,
+			(unsigned long)stats.n_precharge, (unsigned long)stats.n_refresh);
+		fprintf(f, "  Row hits:   %lu of %lu accesses (%.1f%%)\n",
+			(unsigned long)stats.n_row_hit, (unsigned long)accesses,
+			accesses ? 100.0 * stats.n_row_hit / accesses : 0.0);
+		fprintf(f, "  Activates:  %lu reopened the bank's previous row, %lu bank conflicts (different row), %lu first use of bank\n",
+			(unsigned long)stats.n_row_reopen, (unsigned long)stats.n_row_conflict, (unsigned long)misses_cold);
+		fprintf(f, "  Open page:  keeping rows open would avoid %lu activates, about %lu cycles (%.2f%% of time)\n",
+			(unsigned long)stats.n_row_reopen, (unsigned long)reopen_cycles,
+			cycles ? 100.0 * reopen_cycles / cycles : 0.0);
+		fprintf(f, "  Refresh:    %lu cycles busy (%.2f%% of time)\n",
+			(unsigned long)refresh_cycles, cycles ? 100.0 * refresh_cycles / cycles : 0.0);
+		fprintf(f, "  Data:       %lu beats read, %lu beats written, %.1f%% bus utilisation, %.2f MB/s\n",
+			(unsigned long)stats.beats_read, (unsigned long)stats.beats_written,
+			cycles ? 100.0 * beats / cycles : 0.0, secs > 0 ? beats * sizeof(uint16_t) / secs * 1e-6 : 0.0);
+		if (check_en)
+			fprintf(f, "  Violations: %lu\n", (unsigned long)stats.n_violations);
+	}
+
+	size_t size_bytes() const {
+		return pages.size() * PAGE_WORDS * sizeof(uint16_t);
+	}
+
+	// Returns the DQ output for the next SDRAM clock period. The cycle count
+	// is only used for checking and reporting.
+	uint16_t step(int64_t cycle, bool clke, bool cs_n, bool ras_n, bool cas_n, bool we_n,
+			uint32_t ba, uint32_t a, uint8_t dqm, uint16_t dq_in) {
+		cmd_t cmd = cs_n ? CMD_NOP : (cmd_t)(ras_n << 2 | cas_n << 1 | we_n);
+		if (cmd == CMD_NOP && !burst_left && !pipe_busy)
+			return dq_out;
+		if (!clke)
+			return dq_out;
+
+		if (cmd != CMD_NOP && cmd != CMD_BURST_TERM)
+			track_command(cycle, cmd, ba, a);
+
+		uint16_t rdata = 0;
+		bool fetched = false;
+		switch (cmd) {
+		case CMD_READ:
+		case CMD_WRITE:
+			burst_is_write = cmd == CMD_WRITE;
+			burst_bank = ba;
+			burst_col = a & ((1u << col_bits) - 1);
+			burst_ctr = 0;
+			burst_left = burst_is_write && write_burst_single ? 1 : burst_len;
+			burst_auto_precharge = a & 0x400u;
+			break;
+		case CMD_BURST_TERM:
+			burst_left = 0;
+			burst_auto_precharge = false;
+			break;
+		case CMD_PRECHARGE:
+			// Only cuts short a burst to a bank being precharged. Other banks
+			// can be precharged whilst a burst is in progress.
+			if (ba == burst_bank || a & 0x400u) {
+				burst_left = 0;
+				burst_auto_precharge = false;
+			}
+			break;
+		case CMD_ACTIVATE:
+			bank_row[ba] = a & ((1u << row_bits) - 1);
+			break;
+		case CMD_LOAD_MODE:
+			load_mode(a);
+			break;
+		default:
+			break;
+		}
+		// Any other command may be issued whilst a burst continues
+		if (burst_left) {
+			fetched = !burst_is_write;
+			do_beat(cycle, dqm, dq_in, rdata);
+		}
+
+		// Read data comes out cas_latency - 1 calls after it is fetched
+		if (fetched)
+			pipe_busy = cas_latency;
+		else if (pipe_busy)
+			--pipe_busy;
+		rdata_pipe[pipe_ptr % MAX_CAS_LATENCY] = rdata;
+		dq_out = rdata_pipe[(pipe_ptr + MAX_CAS_LATENCY - (cas_latency - 1)) % MAX_CAS_LATENCY];
+		++pipe_ptr;
+		return dq_out;
+	}
+
+	// Backdoor access, at a byte offset. Consecutive bytes are packed
+	// little-endian into consecutive 16-bit words.
+	bool write_bytes(uint32_t offset, const uint8_t *data, size_t len) {
+		if (offset + len > size_bytes())
+			return false;
+		for (size_t i = 0; i < len; ++i) {
+			uint16_t *w = word_ptr((offset + i) / 2, true);
+			int shift = 8 * ((offset + i) % 2);
+			*w = (*w & ~(0xffu << shift)) | (data[i] << shift);
+		}
+		return true;
+	}
+
+	bool read_bytes(uint32_t offset, uint8_t *data, size_t len) {
+		if (offset + len > size_bytes())
+			return false;
+		for (size_t i = 0; i < len; ++i) {
+			const uint16_t *w = word_ptr((offset + i) / 2, false);
+			data[i] = w ? *w >> (8 * ((offset + i) % 2)) : 0;
+		}
+		return true;
+	}
+
+	// Only allocated pages are saved. Bank state is saved so that checking
+	// carries on seamlessly, but statistics start again from zero.
+	void save_state(std::ostream &s) const {
+		s.write((const char*)&burst_len, sizeof(burst_len));
+		s.write((const char*)&burst_interleave, sizeof(burst_interleave));
+		s.write((const char*)&cas_latency, sizeof(cas_latency));
+		s.write((const char*)&write_burst_single, sizeof(write_burst_single));
+		s.write((const char*)bank_row.data(), bank_row.size() * sizeof(uint32_t));
+		s.write((const char*)&burst_left, sizeof(burst_left));
+		s.write((const char*)&burst_ctr, sizeof(burst_ctr));
+		s.write((const char*)&burst_is_write, sizeof(burst_is_write));
+		s.write((const char*)&burst_bank, sizeof(burst_bank));
+		s.write((const char*)&burst_col, sizeof(burst_col));
+		s.write((const char*)rdata_pipe, sizeof(rdata_pipe));
+		s.write((const char*)&pipe_busy, sizeof(pipe_busy));
+		s.write((const char*)&pipe_ptr, sizeof(pipe_ptr));
+		s.write((const char*)&dq_out, sizeof(dq_out));
+		s.write((const char*)&burst_auto_precharge, sizeof(burst_auto_precharge));
+		s.write((const char*)banks.data(), banks.size() * sizeof(bank_t));
+		s.write((const char*)&t_activate_any, sizeof(t_activate_any));
+		s.write((const char*)&bank_activate_any, sizeof(bank_activate_any));
+		s.write((const char*)&t_refresh, sizeof(t_refresh));
+		uint32_t n_pages = 0;
+		for (auto &p : pages)
+			n_pages += !!p;
+		s.write((const char*)&n_pages, sizeof(n_pages));
+		for (uint32_t i = 0; i < pages.size(); ++i) {
+			if (!pages[i])
+				continue;
+			s.write((const char*)&i, sizeof(i));
+			s.write((const char*)pages[i].get(), PAGE_WORDS * sizeof(uint16_t));
+		}
+	}
+
+	bool load_state(std::istream &s) {
+		s.read((char*)&burst_len, sizeof(burst_len));
+		s.read((char*)&burst_interleave, sizeof(burst_interleave));
+		s.read((char*)&cas_latency, sizeof(cas_latency));
+		s.read((char*)&write_burst_single, sizeof(write_burst_single));
+		s.read((char*)bank_row.data(), bank_row.size() * sizeof(uint32_t));
+		s.read((char*)&burst_left, sizeof(burst_left));
+		s.read((char*)&burst_ctr, sizeof(burst_ctr));
+		s.read((char*)&burst_is_write, sizeof(burst_is_write));
+		s.read((char*)&burst_bank, sizeof(burst_bank));
+		s.read((char*)&burst_col, sizeof(burst_col));
+		s.read((char*)rdata_pipe, sizeof(rdata_pipe));
+		s.read((char*)&pipe_busy, sizeof(pipe_busy));
+		s.read((char*)&pipe_ptr, sizeof(pipe_ptr));
+		s.read((char*)&dq_out, sizeof(dq_out));
+		s.read((char*)&burst_auto_precharge, sizeof(burst_auto_precharge));
+		s.read((char*)banks.data(), banks.size() * sizeof(bank_t));
+		s.read((char*)&t_activate_any, sizeof(t_activate_any));
+		s.read((char*)&bank_activate_any, sizeof(bank_activate_any));
+		s.read((char*)&t_refresh, sizeof(t_refresh));
+		for (auto &p : pages)
+			p.reset();
+		uint32_t n_pages = 0;
+		s.read((char*)&n_pages, sizeof(n_pages));
+		for (uint32_t n = 0; n < n_pages && s; ++n) {
+			uint32_t i;
+			s.read((char*)&i, sizeof(i));
+			if (i >= pages.size())
+				return false;
+			s.read((char*)word_ptr(i * PAGE_WORDS, true), PAGE_WORDS * sizeof(uint16_t));
+		}
+		return !!s;
+	}
+};
+
+#endif // _SDRAM_MODEL_H
@@ -2,9 +2,23 @@
 #include <fstream>
 #include <cstdint>
 #include <string>
+#include <memory>
+#include <vector>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
 #include <stdio.h>
+#include <string.h>
 
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <signal.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 
@@ -12,47 +26,49 @@
 #include "dut.cpp"
 #include <backends/cxxrtl/cxxrtl_vcd.h>
 
+#include "wave_file.h"
+#include "sdram_model.h"
+
 // -----------------------------------------------------------------------------
 
-const float CLK_PERIOD = 1 / 40e6;
-const float BAUD_PERIOD = 1 / 3e6;
+// Raw binary serialisation of model state, for checkpoints
+template <typename T>
+static void put_raw(std::ostream &s, const T &x) {
+	s.write((const char*)&x, sizeof(x));
+}
+
+template <typename T>
+static void get_raw(std::istream &s, T &x) {
+	s.read((char*)&x, sizeof(x));
+}
+
+const uint32_t CLK_HZ = 40000000;
+const uint32_t UART_BAUD = 3000000;
+
+// Baud period is generally not a whole number of system clock cycles, so UART
+// timing is tracked in fixed-point cycles. The models are event-driven: each
+// keeps the (integer) cycle of its next edge or sample point, so that most
+// cycles cost a single compare.
+static const int UART_FRAC_BITS = 16;
+
+static inline int64_t uart_fixed_to_cycle(int64_t t) {
+	return (t + (1 << UART_FRAC_BITS) - 1) >> UART_FRAC_BITS;
+}
 
 class UARTRX {
 
-	float baud_period;
-	float time_accum;
+	int64_t baud_period;
+	int64_t next_sample;
+	int64_t next_sample_cycle;
 	int rx_phase;
 	uint8_t rx_data;
 	bool rx_data_valid;
 
-public:
-
-	UARTRX(float _baud_period) {
-		baud_period = _baud_period;
-		time_accum = 0;
-		rx_phase = 0;
-		rx_data = 0;
-		rx_data_valid = false;
-	}
-
-	void sample(bool rx_signal, float delta_t) {
-		time_accum += delta_t;
+	void sample_bit(bool rx_signal) {
 		switch (rx_phase) {
-		case 0:
-			// Wait for start bit.
-			time_accum = 0;
-			if (!rx_signal)
-				rx_phase = 1;
-			break;
 		case 1:
 			// Check start bit, ignore frame if too narrow.
-			if (time_accum >= baud_period * 0.5f) {
-				time_accum -= baud_period * 0.5f;
-				if (rx_signal)
-					rx_phase = 0;
-				else
-					rx_phase = 2;
-			}
+			rx_phase = rx_signal ? 0 : 2;
 			break;
 		case 2: // fall-through
 		case 3: // fall-through
@@ -63,20 +79,43 @@ public:
 		case 8: // fall-through
 		case 9:
 			// Sample data bit in middle of baud period.
-			if (time_accum >= baud_period) {
-				time_accum -= baud_period;
-				rx_data = (rx_data >> 1) | ((uint8_t)rx_signal << 7);
-				++rx_phase;
-			}
+			rx_data = (rx_data >> 1) | ((uint8_t)rx_signal << 7);
+			++rx_phase;
 			break;
 		case 10:
 			// Data is valid only if stop bit is correct
-			if (time_accum >= baud_period * 0.5) {
-				rx_phase = 0;
-				rx_data_valid = rx_signal;
-			}
+			rx_phase = 0;
+			rx_data_valid = rx_signal;
 			break;
 		}
+		next_sample += baud_period;
+		next_sample_cycle = uart_fixed_to_cycle(next_sample);
+	}
+
+public:
+
+	UARTRX(uint32_t clk_hz, uint32_t baud) {
+		baud_period = ((int64_t)clk_hz << UART_FRAC_BITS) / baud;
+		next_sample = 0;
+		next_sample_cycle = 0;
+		rx_phase = 0;
+		rx_data = 0;
+		rx_data_valid = false;
+	}
+
+	// Call once per system clock cycle.
+	inline void sample(bool rx_signal, int64_t cycle) {
+		if (rx_phase == 0) {
+			// Wait for start bit, then sample it again half a baud period later.
+			if (!rx_signal) {
+				rx_phase = 1;
+				next_sample = (cycle << UART_FRAC_BITS) + baud_period / 2;
+				next_sample_cycle = uart_fixed_to_cycle(next_sample);
+			}
+		}
+		else if (cycle >= next_sample_cycle) {
+			sample_bit(rx_signal);
+		}
 	}
 
 	bool rx_valid() {
@@ -87,13 +126,206 @@ public:
 		rx_data_valid = false;
 		return (char)rx_data;;
 	}
+
+	void save_state(std::ostream &s) const {
+		put_raw(s, next_sample);
+		put_raw(s, next_sample_cycle);
+		put_raw(s, rx_phase);
+		put_raw(s, rx_data);
+		put_raw(s, rx_data_valid);
+	}
+
+	void load_state(std::istream &s) {
+		get_raw(s, next_sample);
+		get_raw(s, next_sample_cycle);
+		get_raw(s, rx_phase);
+		get_raw(s, rx_data);
+		get_raw(s, rx_data_valid);
+	}
+};
+
+// Drive the SoC's UART RX line from a file descriptor, e.g. stdin or a file
+// of canned input. The descriptor is polled (without blocking) only when the
+// transmitter is idle, and at most once per few frame times.
+
+class UARTTX {
+
+	int64_t baud_period;
+	int64_t next_edge;
+	int64_t next_edge_cycle;
+	int64_t poll_interval;
+	int fd;
+	uint16_t shift;
+	int bits_left;
+	bool tx;
+
+	static const int BUF_SIZE = 256;
+	uint8_t buf[BUF_SIZE];
+	int buf_ptr;
+	int buf_count;
+
+	int next_char() {
+		if (buf_ptr < buf_count)
+			return buf[buf_ptr++];
+		if (fd < 0)
+			return -1;
+		struct pollfd pfd = {fd, POLLIN, 0};
+		if (poll(&pfd, 1, 0) <= 0)
+			return -1;
+		int rc = read(fd, buf, BUF_SIZE);
+		if (rc <= 0) {
+			// EOF or error: nothing more to send.
+			fd = -1;
+			return -1;
+		}
+		buf_ptr = 1;
+		buf_count = rc;
+		return buf[0];
+	}
+
+	bool step_edge(int64_t cycle) {
+		if (bits_left == 0) {
+			int c = next_char();
+			if (c < 0) {
+				next_edge_cycle = cycle + poll_interval;
+				tx = true;
+				return tx;
+			}
+			// Stop bit, 8 data bits LSB-first, start bit
+			shift = 0x200u | ((uint16_t)c << 1);
+			bits_left = 10;
+			next_edge = cycle << UART_FRAC_BITS;
+		}
+		tx = shift & 0x1u;
+		shift >>= 1;
+		--bits_left;
+		next_edge += baud_period;
+		next_edge_cycle = uart_fixed_to_cycle(next_edge);
+		return tx;
+	}
+
+public:
+
+	UARTTX(uint32_t clk_hz, uint32_t baud, int fd_ = -1) {
+		baud_period = ((int64_t)clk_hz << UART_FRAC_BITS) / baud;
+		poll_interval = uart_fixed_to_cycle(100 * baud_period);
+		fd = fd_;
+		next_edge = 0;
+		next_edge_cycle = 0;
+		shift = 0;
+		bits_left = 0;
+		tx = true;
+		buf_ptr = 0;
+		buf_count = 0;
+	}
+
+	// Call once per system clock cycle. Returns the TX line level.
+	inline bool step(int64_t cycle) {
+		if (cycle < next_edge_cycle)
+			return tx;
+		return step_edge(cycle);
+	}
+
+	// Input not yet sent is not part of the state: after restoring, input
+	// comes from whatever file was passed to this run.
+	void save_state(std::ostream &s) const {
+		put_raw(s, next_edge);
+		put_raw(s, next_edge_cycle);
+		put_raw(s, shift);
+		put_raw(s, bits_left);
+		put_raw(s, tx);
+	}
+
+	void load_state(std::istream &s) {
+		get_raw(s, next_edge);
+		get_raw(s, next_edge_cycle);
+		get_raw(s, shift);
+		get_raw(s, bits_left);
+		get_raw(s, tx);
+	}
+};
+
+// Read-only memory mapping of a whole file. Mapping costs the same however
+// large the file is, pages are only read in when touched, holes in sparse
+// files cost nothing, and concurrent simulations share the page cache.
+
+class MappedFile {
+
+	const uint8_t *data_;
+	size_t size_;
+
+public:
+
+	MappedFile() {
+		data_ = NULL;
+		size_ = 0;
+	}
+
+	~MappedFile() {
+		if (data_)
+			munmap((void*)data_, size_);
+	}
+
+	bool open(const std::string &path) {
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+		struct stat st;
+		if (fstat(fd, &st) < 0) {
+			::close(fd);
+			return false;
+		}
+		size_ = st.st_size;
+		if (size_ > 0) {
+			void *p = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p == MAP_FAILED) {
+				::close(fd);
+				size_ = 0;
+				return false;
+			}
+			data_ = (const uint8_t*)p;
+		}
+		// Mapping stays valid after the descriptor is closed
+		::close(fd);
+		return true;
+	}
+
+	const uint8_t *data() const {
+		return data_;
+	}
+
+	size_t size() const {
+		return size_;
+	}
 };
 
+// SPI flash model, SPI mode 0. Supports the common read commands:
+//
+//   03h  Read                      1-1-1, no dummy cycles
+//   0Bh  Fast Read                 1-1-1, 8 dummy cycles
+//   3Bh  Fast Read Dual Output     1-1-2, 8 dummy cycles
+//   6Bh  Fast Read Quad Output     1-1-4, 8 dummy cycles
+//   EBh  Fast Read Quad I/O        1-4-4, 2 mode + 4 dummy cycles
+//
+// EBh mode bits M[5:4] = 10 enable continuous read: the next transfer skips
+// the command and starts straight at the address. Any other command goes to
+// an error state which drives zeroes until deselect.
+//
+// step_io() is the full 4-bit interface: bit n of io is IOn. step() is the
+// plain single-bit interface used by spi_mini, where IO0 is MOSI and IO1 is
+// MISO, so only 03h and 0Bh are usable from the current SoC.
+//
+// Flash contents are a list of images at different flash addresses, each
+// either a mapped file or a buffer owned by the caller. Where images overlap,
+// the most recently added wins. Unpopulated flash reads as all-ones.
+
 class SPIMem {
 
 	enum phase_t {
 		CMD,
 		ADDR,
+		MODE,
+		DUMMY,
 		DATA,
 		ERR
 	};
@@ -101,106 +333,1137 @@ class SPIMem {
 
 	uint8_t cmd;
 	uint32_t addr;
+	uint8_t mode;
 	int shift_ctr;
+	int addr_width;
+	int data_width;
+	int dummy_cycles;
+	bool continuous;
 	bool sck_prev;
-	bool miso;
+	uint8_t io_out;
+	uint8_t io_oe;
 
-	uint32_t base_addr;
-	const uint8_t *img;
-	size_t img_size;
+	struct region_t {
+		uint32_t base;
+		size_t size;
+		const uint8_t *data;
+	};
+	std::vector<region_t> regions;
+	std::vector<std::unique_ptr<MappedFile>> files;
 
 	uint8_t get(uint32_t addr) const {
-		addr -= base_addr;
-		if (addr >= img_size)
-			return 0xffu;
-		else
-			return img[addr];
+		for (size_t i = regions.size(); i-- > 0;) {
+			uint32_t offs = addr - regions[i].base;
+			if (offs < regions[i].size)
+				return regions[i].data[offs];
+		}
+		return 0xffu;
 	}
 
-public:
+	// Returns false for unsupported commands
+	bool decode_cmd(uint8_t c) {
+		addr_width = 1;
+		dummy_cycles = 8;
+		switch (c) {
+		case 0x03u: data_width = 1; dummy_cycles = 0; break;
+		case 0x0bu: data_width = 1; break;
+		case 0x3bu: data_width = 2; break;
+		case 0x6bu: data_width = 4; break;
+		case 0xebu: data_width = 4; addr_width = 4; dummy_cycles = 4; break;
+		default: return false;
+		}
+		return true;
+	}
 
-	SPIMem(const uint8_t *img_, size_t img_size_, uint32_t base_addr_) {
+	void deselect(bool sck) {
 		phase = CMD;
 		cmd = 0;
+		if (continuous) {
+			decode_cmd(0xebu);
+			phase = ADDR;
+			cmd = 0xebu;
+		}
 		addr = 0;
+		mode = 0;
 		shift_ctr = 0;
-		sck_prev = false;
-		miso = false;
-		base_addr = base_addr_;
-		img = img_;
-		img_size = img_size_;
+		sck_prev = sck;
+		io_out = 0;
+		io_oe = 0;
 	}
 
-	bool step(bool cs_n, bool sck, bool mosi) {
+public:
+
+	SPIMem() {
+		continuous = false;
+		addr_width = 1;
+		data_width = 1;
+		dummy_cycles = 0;
+		deselect(false);
+	}
+
+	void add_image(const uint8_t *data, size_t size, uint32_t base) {
+		regions.push_back({base, size, data});
+	}
+
+	bool add_image(const std::string &path, uint32_t base) {
+		std::unique_ptr<MappedFile> f(new MappedFile);
+		if (!f->open(path))
+			return false;
+		add_image(f->data(), f->size(), base);
+		files.push_back(std::move(f));
+		return true;
+	}
+
+	// Returns the IO output levels. Pins not driven by the flash (see
+	// io_output_enable()) read as 0.
+	uint8_t step_io(bool cs_n, bool sck, uint8_t io_in) {
 		// Soft-reset of interface on deselect
 		if (cs_n) {
-			phase = CMD;
-			cmd = 0;
-			addr = 0;
-			shift_ctr = 0;
+			if (phase != CMD || shift_ctr != 0)
+				deselect(sck);
 			sck_prev = sck;
-			miso = false;
-			return miso;
+			return io_out;
 		}
 
+		bool rising = sck && !sck_prev;
+		bool falling = !sck && sck_prev;
+		sck_prev = sck;
+
 		switch (phase) {
 		case CMD:
-			miso = false;
-			if (!(sck && !sck_prev))
+			if (!rising)
 				break;
-
-			cmd = (cmd << 1) | mosi;
+			cmd = (cmd << 1) | (io_in & 0x1u);
 			if (++shift_ctr >= 8) {
-				phase = ADDR;
 				shift_ctr = 0;
-				if (cmd != 0x03u)
-					phase = ERR;
+				phase = decode_cmd(cmd) ? ADDR : ERR;
 			}
 			break;
 
 		case ADDR:
-			if (!(sck && !sck_prev))
+			if (!rising)
 				break;
+			addr = (addr << addr_width) | (io_in & ((1u << addr_width) - 1));
+			shift_ctr += addr_width;
+			if (shift_ctr >= 24) {
+				shift_ctr = 0;
+				addr &= 0xffffffu;
+				phase = cmd == 0xebu ? MODE : dummy_cycles ? DUMMY : DATA;
+			}
+			break;
 
-			addr = (addr << 1) | mosi;
-			if (++shift_ctr >= 24) {
-				phase = DATA;
+		case MODE:
+			if (!rising)
+				break;
+			mode = (mode << 4) | (io_in & 0xfu);
+			shift_ctr += 4;
+			if (shift_ctr >= 8) {
 				shift_ctr = 0;
+				continuous = (mode & 0x30u) == 0x20u;
+				phase = DUMMY;
 			}
+			break;
 
-		case DATA:
-			if (!(!sck && sck_prev))
+		case DUMMY:
+			if (!rising)
 				break;
+			if (++shift_ctr >= dummy_cycles) {
+				shift_ctr = 0;
+				phase = DATA;
+			}
+			break;
 
-			miso = (get(addr) >> (7 - shift_ctr)) & 0x1u;
-			if (++shift_ctr >= 8) {
+		case DATA: {
+			if (!falling)
+				break;
+			uint8_t lane_mask = (1u << data_width) - 1;
+			uint8_t bits = (get(addr) >> (8 - data_width - shift_ctr)) & lane_mask;
+			// Single-bit data comes out on IO1 (MISO)
+			io_out = data_width == 1 ? bits << 1 : bits;
+			io_oe = data_width == 1 ? 0x2u : lane_mask;
+			shift_ctr += data_width;
+			if (shift_ctr >= 8) {
 				++addr;
 				shift_ctr = 0;
 			}
 			break;
-				
+		}
+
 		case ERR:
-			miso = false;
+			io_out = 0;
 			break;
 
 		}
-		sck_prev = sck;
-		return miso;
+		return io_out;
+	}
+
+	uint8_t io_output_enable() const {
+		return io_oe;
+	}
+
+	bool step(bool cs_n, bool sck, bool mosi) {
+		return (step_io(cs_n, sck, mosi) >> 1) & 0x1u;
+	}
+
+	void save_state(std::ostream &s) const {
+		put_raw(s, phase);
+		put_raw(s, cmd);
+		put_raw(s, addr);
+		put_raw(s, mode);
+		put_raw(s, shift_ctr);
+		put_raw(s, addr_width);
+		put_raw(s, data_width);
+		put_raw(s, dummy_cycles);
+		put_raw(s, continuous);
+		put_raw(s, sck_prev);
+		put_raw(s, io_out);
+		put_raw(s, io_oe);
+	}
+
+	void load_state(std::istream &s) {
+		get_raw(s, phase);
+		get_raw(s, cmd);
+		get_raw(s, addr);
+		get_raw(s, mode);
+		get_raw(s, shift_ctr);
+		get_raw(s, addr_width);
+		get_raw(s, data_width);
+		get_raw(s, dummy_cycles);
+		get_raw(s, continuous);
+		get_raw(s, sck_prev);
+		get_raw(s, io_out);
+		get_raw(s, io_oe);
+	}
+};
+
+// -----------------------------------------------------------------------------
+
+// OpenOCD remote_bitbang server. Commands are one ASCII character each:
+// '0'-'7' drive TCK/TMS/TDI, 'r'-'u' drive TRST, 'R' reads TDO, 'Q' quits.
+//
+// In lockstep mode the simulation blocks on the socket and advances exactly
+// one cycle per TCK/TMS/TDI write, which gives repeatable traces. Otherwise
+// the simulation free-runs and the socket is polled without blocking; queued
+// commands are applied one per cycle as they arrive, and the poll interval
+// backs off whilst the socket is idle so that an attached-but-idle debugger
+// costs (almost) nothing.
+
+static const int TCP_BUF_SIZE = 256;
+
+class RemoteBitbang {
+
+	static const int POLL_INTERVAL_MAX = 1024;
+
+	int sock_fd;
+	bool lockstep;
+	char txbuf[TCP_BUF_SIZE];
+	char rxbuf[TCP_BUF_SIZE];
+	int rx_ptr;
+	int rx_remaining;
+	int tx_ptr;
+	int poll_interval;
+	int poll_countdown;
+
+	void flush_tx() {
+		if (tx_ptr > 0) {
+			send(sock_fd, txbuf, tx_ptr, 0);
+			tx_ptr = 0;
+		}
+	}
+
+	// Returns false if no data was available (only possible if !blocking)
+	bool fill_rx(bool blocking) {
+		// Potentially the last command was not a read command, but OpenOCD is
+		// still waiting for a last response from its last command packet
+		// before it sends us any more, so now is the time to flush TX.
+		flush_tx();
+		rx_ptr = 0;
+		int rc = recv(sock_fd, rxbuf, TCP_BUF_SIZE, blocking ? 0 : MSG_DONTWAIT);
+		if (rc > 0) {
+			rx_remaining = rc;
+			return true;
+		}
+		rx_remaining = 0;
+		if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+			return false;
+		printf("OpenOCD disconnected\n");
+		got_exit_cmd = true;
+		return false;
+	}
+
+	// Apply buffered commands up to and including the first one which
+	// requires a clock step. Returns true if such a command was found.
+	bool apply_cmds(cxxrtl_design::p_tb &top) {
+		while (rx_remaining > 0) {
+			char c = rxbuf[rx_ptr++];
+			--rx_remaining;
+
+			if (c == 'r' || c == 's') {
+				top.p_trst__n.set<bool>(true);
+				return true;
+			}
+			else if (c == 't' || c == 'u') {
+				top.p_trst__n.set<bool>(false);
+			}
+			else if (c >= '0' && c <= '7') {
+				int mask = c - '0';
+				top.p_tck.set<bool>(mask & 0x4);
+				top.p_tms.set<bool>(mask & 0x2);
+				top.p_tdi.set<bool>(mask & 0x1);
+				return true;
+			}
+			else if (c == 'R') {
+				txbuf[tx_ptr++] = top.p_tdo.get<bool>() ? '1' : '0';
+				if (tx_ptr >= TCP_BUF_SIZE || rx_remaining == 0)
+					flush_tx();
+			}
+			else if (c == 'Q') {
+				printf("OpenOCD sent quit command\n");
+				got_exit_cmd = true;
+				return true;
+			}
+		}
+		return false;
+	}
+
+public:
+
+	bool got_exit_cmd;
+
+	RemoteBitbang(int sock_fd_, bool lockstep_) {
+		sock_fd = sock_fd_;
+		lockstep = lockstep_;
+		rx_ptr = 0;
+		rx_remaining = 0;
+		tx_ptr = 0;
+		poll_interval = 1;
+		poll_countdown = 0;
+		got_exit_cmd = false;
+	}
+
+	// Call once per system clock cycle. Most bitbang commands complete in one
+	// cycle (e.g. TCK/TMS/TDI writes) but reads take 0 cycles.
+	void step(cxxrtl_design::p_tb &top) {
+		if (lockstep) {
+			while (!got_exit_cmd && !apply_cmds(top))
+				fill_rx(true);
+			return;
+		}
+
+		if (apply_cmds(top))
+			return;
+		// Buffer is drained. Respond promptly whilst a debugger is talking to
+		// us, but back off exponentially once it goes quiet.
+		if (poll_countdown > 0) {
+			--poll_countdown;
+			return;
+		}
+		if (fill_rx(false)) {
+			poll_interval = 1;
+			apply_cmds(top);
+		}
+		else if (poll_interval < POLL_INTERVAL_MAX) {
+			poll_interval *= 2;
+		}
+		poll_countdown = poll_interval - 1;
+	}
+};
+
+// -----------------------------------------------------------------------------
+// Host-side performance reporting
+
+typedef std::chrono::steady_clock host_clock;
+
+static double seconds_since(host_clock::time_point t) {
+	return std::chrono::duration<double>(host_clock::now() - t).count();
+}
+
+// Attributes host time to regions of the main loop. mark(r) charges all time
+// since the previous mark() to region r, so there is one clock read per
+// region per cycle. Only used when --profile is passed.
+class HostProfile {
+public:
+	enum region_t {
+		STEP,
+		WAVES,
+		MODELS,
+		SOCKET,
+		N_REGIONS
+	};
+
+private:
+	host_clock::time_point last;
+	host_clock::duration acc[N_REGIONS];
+
+public:
+	HostProfile() {
+		last = host_clock::now();
+		for (int i = 0; i < N_REGIONS; ++i)
+			acc[i] = host_clock::duration::zero();
+	}
+
+	inline void mark(region_t r) {
+		host_clock::time_point now = host_clock::now();
+		acc[r] += now - last;
+		last = now;
+	}
+
+	void report(FILE *f) const {
+		static const char *region_names[N_REGIONS] = {
+			"top.step()",
+			"waveform dump",
+			"peripheral models",
+			"socket I/O"
+		};
+		double total = 0;
+		for (int i = 0; i < N_REGIONS; ++i)
+			total += std::chrono::duration<double>(acc[i]).count();
+		fprintf(f, "Host time breakdown:\n");
+		for (int i = 0; i < N_REGIONS; ++i) {
+			double t = std::chrono::duration<double>(acc[i]).count();
+			fprintf(f, "    %-18s %9.3f s  %5.1f%%\n", region_names[i], t, total > 0 ? 100.0 * t / total : 0.0);
+		}
 	}
 };
 
+static void report_speed(FILE *f, int64_t cycles, double wallclock) {
+	fprintf(f, "%ld cycles in %.2f s (%.0f cycles/s)\n",
+		(long)cycles, wallclock, wallclock > 0 ? cycles / wallclock : 0.0);
+}
+
+static volatile sig_atomic_t got_sigint = 0;
+
+static void handle_sigint(int) {
+	got_sigint = 1;
+}
+
+// -----------------------------------------------------------------------------
+// Testbench plumbing shared by interactive and batch runs
+
+static const uint32_t FLASH_LOAD_ADDR = 0x100000u;
+
+// SDRAM controller register values written by sdram_init_seq()
+static const uint32_t SDRAM_TIME_DEFAULT = 0x01010002u;
+static const uint32_t SDRAM_REFRESH_DEFAULT = 312;
+
+struct FileLoad {
+	std::string path;
+	uint32_t addr;
+};
+
+// Argument format is file@addr
+static bool parse_file_load(const std::string &arg, FileLoad &load) {
+	size_t at = arg.rfind('@');
+	if (at == std::string::npos || at == 0 || at + 1 == arg.size())
+		return false;
+	load.path = arg.substr(0, at);
+	load.addr = std::stoul(arg.substr(at + 1), 0, 0);
+	return true;
+}
+
+static bool read_bin(const std::string &path, std::vector<uint8_t> &data) {
+	std::ifstream fd(path, std::ios::binary | std::ios::ate);
+	if (!fd)
+		return false;
+	data.resize(fd.tellg());
+	fd.seekg(0, std::ios::beg);
+	fd.read((char*)data.data(), data.size());
+	return true;
+}
+
+// Reset + initial clock pulse
+static void reset_design(cxxrtl_design::p_tb &top) {
+	top.step();
+	top.p_clk__sys.set<bool>(true);
+	top.p_tck.set<bool>(true);
+	top.step();
+	top.p_clk__sys.set<bool>(false);
+	top.p_tck.set<bool>(false);
+	top.p_trst__n.set<bool>(true);
+	top.p_rst__n__por.set<bool>(true);
+	top.step();
+	top.step(); // workaround for github.com/YosysHQ/yosys/issues/2780
+}
+
+// Some CXXRTL versions do not fully settle the design in one step() after a
+// clock edge (github.com/YosysHQ/yosys/issues/2780), so historically we have
+// stepped twice per edge, which doubles the cost of every cycle. The second
+// step is only useful if it changes something, so in "auto" mode we keep
+// doing it for the first RESTEP_CALIBRATION_EDGES edges after reset, and
+// drop it if it never had any effect. After that, one edge in every
+// RESTEP_SAMPLE_INTERVAL is still re-stepped, and the workaround comes back
+// for good if any of them was unsettled. Edges between samples are not
+// checked, so "auto" can still get a cycle wrong: it is opt-in, and the
+// default is to always re-step.
+//
+// Build with CDEFINES=CXXRTL_ISSUE_2780_FIXED to default to never re-stepping.
+
+enum restep_t {
+	RESTEP_NEVER,
+	RESTEP_AUTO,
+	RESTEP_ALWAYS
+};
+
+#ifdef CXXRTL_ISSUE_2780_FIXED
+static const restep_t RESTEP_DEFAULT = RESTEP_NEVER;
+#else
+static const restep_t RESTEP_DEFAULT = RESTEP_ALWAYS;
+#endif
+
+class ClockStepper {
+
+	static const int64_t RESTEP_CALIBRATION_EDGES = 200000;
+	static const int RESTEP_SAMPLE_INTERVAL = 1024;
+
+	restep_t mode;
+	int64_t calibration_left;
+	int sample_left;
+	bool verbose;
+
+	// Equivalent to step(), but returns true only if this changed any state,
+	// i.e. the previous step() had not really settled.
+	static bool restep(cxxrtl_design::p_tb &top) {
+		bool converged = top.eval();
+		if (!top.commit())
+			return false;
+		if (!converged)
+			top.step();
+		return true;
+	}
+
+public:
+
+	int64_t unsettled_edges;
+
+	ClockStepper(restep_t mode_, bool verbose_ = true) {
+		mode = mode_;
+		calibration_left = RESTEP_CALIBRATION_EDGES;
+		sample_left = RESTEP_SAMPLE_INTERVAL;
+		verbose = verbose_;
+		unsettled_edges = 0;
+	}
+
+	inline void edge(cxxrtl_design::p_tb &top, bool clk) {
+		top.p_clk__sys.set<bool>(clk);
+		top.step();
+		if (mode == RESTEP_NEVER)
+			return;
+		bool calibrated = mode == RESTEP_AUTO && calibration_left == 0;
+		if (calibrated) {
+			if (--sample_left)
+				return;
+			sample_left = RESTEP_SAMPLE_INTERVAL;
+		}
+		if (restep(top)) {
+			++unsettled_edges;
+			if (calibrated) {
+				mode = RESTEP_ALWAYS;
+				if (verbose)
+					fprintf(stderr, "step() left design unsettled after calibration: restoring workaround\n");
+			}
+		}
+		if (mode == RESTEP_AUTO && !calibrated && --calibration_left == 0) {
+			if (unsettled_edges)
+				mode = RESTEP_ALWAYS;
+			if (verbose) {
+				if (unsettled_edges)
+					fprintf(stderr, "step() left design unsettled on %ld clock edges: keeping workaround\n",
+						(long)unsettled_edges);
+				else
+					fprintf(stderr, "step() always settled in %ld clock edges: checking 1 in %d from now on\n",
+						(long)RESTEP_CALIBRATION_EDGES, RESTEP_SAMPLE_INTERVAL);
+			}
+		}
+	}
+};
+
+// CXXRTL debug item names use spaces as the hierarchy separator
+static std::string debug_name(std::string name) {
+	for (auto &c : name)
+		if (c == '.')
+			c = ' ';
+	return name;
+}
+
+static uint64_t debug_item_value(const cxxrtl::debug_item &item) {
+	uint64_t v = item.curr[0];
+	if (item.width > 32)
+		v |= (uint64_t)item.curr[1] << 32;
+	else if (item.width < 32)
+		v &= (1u << item.width) - 1;
+	return v;
+}
+
+static inline void step_spi(cxxrtl_design::p_tb &top, SPIMem &spi) {
+	top.p_spi0__sdi.set<bool>(spi.step(
+		top.p_spi0__cs__n.get<bool>(),
+		top.p_spi0__sclk.get<bool>(),
+		top.p_spi0__sdo.get<bool>()
+	));
+}
+
+// Call after each falling clk_sys edge (SDRAM clock rising edge). Pins are
+// registered on clk_sys posedge, so they're stable here, and the new DQ
+// value is not seen by the capture flop until the next falling edge.
+static inline void step_sdram(cxxrtl_design::p_tb &top, SDRAMModel &sdram, int64_t cycle) {
+	top.p_sdram__dq__i.set<uint16_t>(sdram.step(
+		cycle,
+		top.p_sdram__clke.get<bool>(),
+		top.p_sdram__cs__n.get<bool>(),
+		top.p_sdram__ras__n.get<bool>(),
+		top.p_sdram__cas__n.get<bool>(),
+		top.p_sdram__we__n.get<bool>(),
+		top.p_sdram__ba.get<uint32_t>(),
+		top.p_sdram__a.get<uint32_t>(),
+		top.p_sdram__dqm.get<uint8_t>(),
+		top.p_sdram__dq__o.get<uint16_t>()
+	));
+}
+
+// -----------------------------------------------------------------------------
+// Shared cache statistics (--cache-stats)
+//
+// Watches both sides of the shared cache through CXXRTL's debug interface.
+// Every SDRAM access accepted on the upstream side counts as an access by
+// the master (core or DMA) which made it. Every read burst on the downstream
+// side is a line fill, and counts as a miss for the master whose access is
+// stalled on it.
+// Every SDRAM write burst is a writeback.
+
+class CacheStats {
+
+	// Core 0, core 1, DMA
+	static const int N_MASTERS = 3;
+
+	cxxrtl::debug_items items;
+	const cxxrtl::debug_item *src_hready;
+	const cxxrtl::debug_item *src_htrans;
+	const cxxrtl::debug_item *src_haddr;
+	const cxxrtl::debug_item *src_hmaster;
+	const cxxrtl::debug_item *dst_hready;
+	const cxxrtl::debug_item *dst_htrans;
+	const cxxrtl::debug_item *dst_hwrite;
+	const cxxrtl::debug_item *dst_haddr;
+
+	uint32_t last_master;
+	uint64_t accesses[N_MASTERS];
+	uint64_t misses[N_MASTERS];
+	uint64_t writebacks;
+
+	const cxxrtl::debug_item *find(const char *name) const {
+		auto it = items.table.find(name);
+		if (it == items.table.end() || it->second.empty() ||
+			!(it->second[0].type == cxxrtl::debug_item::VALUE || it->second[0].type == cxxrtl::debug_item::WIRE)) {
+			std::cerr << "Can't find signal \"" << name << "\" for --cache-stats\n";
+			return NULL;
+		}
+		return &it->second[0];
+	}
+
+	// SDRAM is the lower half of the cache's 128 MiB window, IO the upper
+	static bool is_sdram(uint64_t addr) {
+		return !(addr & (1u << 26));
+	}
+
+public:
+
+	CacheStats() {
+		last_master = 0;
+		memset(accesses, 0, sizeof(accesses));
+		memset(misses, 0, sizeof(misses));
+		writebacks = 0;
+	}
+
+	bool init(cxxrtl_design::p_tb &top) {
+		top.debug_info(items);
+		return
+			(src_hready  = find("soc_u cache_src_hready")) &&
+			(src_htrans  = find("soc_u cache_src_htrans")) &&
+			(src_haddr   = find("soc_u cache_src_haddr")) &&
+			(src_hmaster = find("soc_u cache_src_hmaster")) &&
+			(dst_hready  = find("soc_u cache_dst_hready")) &&
+			(dst_htrans  = find("soc_u cache_dst_htrans")) &&
+			(dst_hwrite  = find("soc_u cache_dst_hwrite")) &&
+			(dst_haddr   = find("soc_u cache_dst_haddr"));
+	}
+
+	// Call once per cycle, after the rising clock edge
+	void sample() {
+		// NONSEQ only: the cache sees single transfers from its masters, and
+		// each burst it issues downstream is one line.
+		const uint64_t HTRANS_NONSEQ = 2;
+		if (debug_item_value(*src_hready) && debug_item_value(*src_htrans) == HTRANS_NONSEQ &&
+			is_sdram(debug_item_value(*src_haddr))) {
+			last_master = debug_item_value(*src_hmaster) % N_MASTERS;
+			++accesses[last_master];
+		}
+		if (debug_item_value(*dst_hready) && debug_item_value(*dst_htrans) == HTRANS_NONSEQ &&
+			is_sdram(debug_item_value(*dst_haddr))) {
+			if (debug_item_value(*dst_hwrite))
+				++writebacks;
+			else
+				++misses[last_master];
+		}
+	}
+
+	void report(FILE *f) const {
+		uint64_t total_accesses = 0, total_misses = 0;
+		fprintf(f, "Shared cache statistics (SDRAM accesses only):\n");
+		for (int i = 0; i < N_MASTERS; ++i) {
+			if (i < 2)
+				fprintf(f, "  Core %d:     ", i);
+			else
+				fprintf(f, "  DMA:        ");
+			fprintf(f, "%lu accesses, %lu misses (%.2f%%)\n",
+				(unsigned long)accesses[i], (unsigned long)misses[i],
+				accesses[i] ? 100.0 * misses[i] / accesses[i] : 0.0);
+			total_accesses += accesses[i];
+			total_misses += misses[i];
+		}
+		fprintf(f, "  Total:      %lu accesses, %lu misses (%.2f%%), %lu writebacks\n",
+			(unsigned long)total_accesses, (unsigned long)total_misses,
+			total_accesses ? 100.0 * total_misses / total_accesses : 0.0, (unsigned long)writebacks);
+	}
+};
+
+// -----------------------------------------------------------------------------
+// Simulation checkpoints (--save-state/--load-state)
+//
+// Design state is captured through CXXRTL's debug interface: every wire,
+// value and memory it exposes (registers, TCMs, cache tag/data RAMs...) is
+// stored by hierarchical name, followed by the C++ peripheral and SDRAM
+// model state and the current cycle count. A checkpoint can only be
+// restored into a design built from the same RTL.
+
+static const char CHECKPOINT_MAGIC[8] = {'C', 'S', 'o', 'C', 'S', 'I', 'M', '4'};
+
+static size_t debug_item_chunks(const cxxrtl::debug_item &item) {
+	size_t chunks = (item.width + 31) / 32;
+	return item.type == cxxrtl::debug_item::MEMORY ? chunks * item.depth : chunks;
+}
+
+static bool debug_item_is_state(const cxxrtl::debug_item &item) {
+	// Aliases share storage with some other item, and anything else is
+	// computed on demand.
+	return item.type == cxxrtl::debug_item::VALUE ||
+		item.type == cxxrtl::debug_item::WIRE ||
+		item.type == cxxrtl::debug_item::MEMORY;
+}
+
+static bool save_checkpoint(const std::string &path, cxxrtl_design::p_tb &top, int64_t cycle,
+		const SPIMem &spi0, const UARTRX &uart0, const UARTTX &uart0_in, const SDRAMModel &sdram) {
+	std::ofstream s(path, std::ios::binary);
+	if (!s)
+		return false;
+	cxxrtl::debug_items items;
+	top.debug_info(items);
+
+	s.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+	put_raw(s, cycle);
+	spi0.save_state(s);
+	uart0.save_state(s);
+	uart0_in.save_state(s);
+	sdram.save_state(s);
+
+	uint32_t n_items = 0;
+	for (auto &it : items.table)
+		for (auto &part : it.second)
+			n_items += debug_item_is_state(part);
+	put_raw(s, n_items);
+
+	for (auto &it : items.table) {
+		for (size_t i = 0; i < it.second.size(); ++i) {
+			const cxxrtl::debug_item &item = it.second[i];
+			if (!debug_item_is_state(item))
+				continue;
+			uint32_t name_len = it.first.size();
+			uint32_t part = i;
+			uint64_t n_chunks = debug_item_chunks(item);
+			put_raw(s, name_len);
+			s.write(it.first.data(), name_len);
+			put_raw(s, part);
+			put_raw(s, n_chunks);
+			s.write((const char*)item.curr, n_chunks * sizeof(cxxrtl::chunk_t));
+		}
+	}
+	return !!s;
+}
+
+static bool load_checkpoint(const std::string &path, cxxrtl_design::p_tb &top, int64_t &cycle,
+		SPIMem &spi0, UARTRX &uart0, UARTTX &uart0_in, SDRAMModel &sdram) {
+	std::ifstream s(path, std::ios::binary);
+	if (!s)
+		return false;
+	cxxrtl::debug_items items;
+	top.debug_info(items);
+
+	char magic[sizeof(CHECKPOINT_MAGIC)];
+	s.read(magic, sizeof(magic));
+	if (!s || memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0) {
+		std::cerr << "Not a checkpoint file: " << path << "\n";
+		return false;
+	}
+	get_raw(s, cycle);
+	spi0.load_state(s);
+	uart0.load_state(s);
+	uart0_in.load_state(s);
+	if (!sdram.load_state(s)) {
+		std::cerr << "Bad SDRAM contents in checkpoint file: " << path << "\n";
+		return false;
+	}
+
+	uint32_t n_items;
+	get_raw(s, n_items);
+	size_t n_missing = 0;
+	std::vector<cxxrtl::chunk_t> discard;
+	for (uint32_t i = 0; i < n_items && s; ++i) {
+		uint32_t name_len, part;
+		uint64_t n_chunks;
+		get_raw(s, name_len);
+		std::string name(name_len, '\0');
+		s.read(&name[0], name_len);
+		get_raw(s, part);
+		get_raw(s, n_chunks);
+
+		auto it = items.table.find(name);
+		if (it == items.table.end() || part >= it->second.size() ||
+			debug_item_chunks(it->second[part]) != n_chunks) {
+			++n_missing;
+			discard.resize(n_chunks);
+			s.read((char*)discard.data(), n_chunks * sizeof(cxxrtl::chunk_t));
+			continue;
+		}
+		const cxxrtl::debug_item &item = it->second[part];
+		s.read((char*)item.curr, n_chunks * sizeof(cxxrtl::chunk_t));
+		if (item.next)
+			memcpy(item.next, item.curr, n_chunks * sizeof(cxxrtl::chunk_t));
+	}
+	if (!s) {
+		std::cerr << "Truncated checkpoint file: " << path << "\n";
+		return false;
+	}
+	if (n_missing)
+		fprintf(stderr, "Warning: %zu items in checkpoint not found in design\n", n_missing);
+	// Settle any combinational logic not captured in the checkpoint
+	top.step();
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Backdoor memory loading (--sdram-load/--tcm-load)
+//
+// Writes file contents straight into the SDRAM model, or into the TCM RTL
+// memory arrays through CXXRTL's debug interface, so no simulated cycles are
+// spent getting them there.
+
+static const uint32_t TCM_BASE = 0x00000000u;
+static const uint32_t SDRAM_BASE = 0x08000000u;
+static const uint32_t SDRAM_SIZE = 0x04000000u;
+
+// Find the largest memory under a hierarchy scope, e.g. the storage array of
+// an SRAM wrapper, without needing to know its internal names.
+static const cxxrtl::debug_item *find_memory(const cxxrtl::debug_items &items, const std::string &scope) {
+	const cxxrtl::debug_item *found = NULL;
+	std::string prefix = scope + " ";
+	for (auto &it : items.table) {
+		if (it.first.compare(0, prefix.size(), prefix) != 0)
+			continue;
+		for (auto &part : it.second) {
+			if (part.type == cxxrtl::debug_item::MEMORY && (!found || part.depth > found->depth))
+				found = &part;
+		}
+	}
+	return found;
+}
+
+// Write bytes to a memory at a byte offset, assuming little-endian packing of
+// bytes into memory words, and consecutive words at consecutive addresses.
+static bool backdoor_write(const cxxrtl::debug_item &mem, uint32_t offset, const uint8_t *data, size_t len) {
+	if (mem.width % 8 != 0)
+		return false;
+	size_t bytes_per_word = mem.width / 8;
+	size_t chunks_per_word = (mem.width + 31) / 32;
+	if (offset + len > mem.depth * bytes_per_word)
+		return false;
+	for (size_t i = 0; i < len; ++i) {
+		size_t word = (offset + i) / bytes_per_word;
+		size_t lane = (offset + i) % bytes_per_word;
+		cxxrtl::chunk_t *chunk = &mem.curr[word * chunks_per_word + lane / 4];
+		int shift = 8 * (lane % 4);
+		*chunk = (*chunk & ~(0xffu << shift)) | ((cxxrtl::chunk_t)data[i] << shift);
+	}
+	return true;
+}
+
+static bool backdoor_load(cxxrtl_design::p_tb &top, SDRAMModel &sdram, const std::vector<FileLoad> &sdram_loads,
+		const std::vector<FileLoad> &tcm_loads) {
+	cxxrtl::debug_items items;
+	top.debug_info(items);
+
+	const cxxrtl::debug_item *tcm_mem[2] = {
+		find_memory(items, "soc_u cpu0_tcm"),
+		find_memory(items, "soc_u cpu1_tcm")
+	};
+
+	std::vector<uint8_t> data;
+	for (auto &load : sdram_loads) {
+		if (!read_bin(load.path, data)) {
+			std::cerr << "Failed to open \"" << load.path << "\"\n";
+			return false;
+		}
+		// SDRAM model storage is indexed by {row, bank, column}, which is the
+		// same order as the controller's address mapping, so it's linear in
+		// system address.
+		if (load.addr < SDRAM_BASE || load.addr + data.size() > SDRAM_BASE + SDRAM_SIZE ||
+			!sdram.write_bytes(load.addr - SDRAM_BASE, data.data(), data.size())) {
+			fprintf(stderr, "Can't load %s (%zu bytes) to SDRAM at %08x\n", load.path.c_str(), data.size(), load.addr);
+			return false;
+		}
+	}
+	// Same contents go to both TCMs, as with the RTL preload file
+	for (auto &load : tcm_loads) {
+		if (!read_bin(load.path, data)) {
+			std::cerr << "Failed to open \"" << load.path << "\"\n";
+			return false;
+		}
+		for (int i = 0; i < 2; ++i) {
+			if (!tcm_mem[i] || load.addr < TCM_BASE ||
+				!backdoor_write(*tcm_mem[i], load.addr - TCM_BASE, data.data(), data.size())) {
+				fprintf(stderr, "Can't load %s (%zu bytes) to TCM%d at %08x\n", load.path.c_str(), data.size(), i, load.addr);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Batch regression mode: run many firmware images, each on its own design
+// instance, across a pool of worker threads.
+//
+// Manifest has one job per line, whitespace-separated:
+//
+//     <flash bin> <max cycles> <expected UART output file>
+//
+// Blank lines and lines starting with '#' are ignored. A job passes as soon
+// as the expected text appears in its UART output, and fails if max cycles
+// is reached first.
+
+struct RegressionJob {
+	std::string bin_path;
+	int64_t max_cycles;
+	std::string expect_path;
+
+	bool pass;
+	int64_t cycles;
+	double wallclock;
+	std::string err;
+};
+
+static bool read_manifest(const std::string &path, std::vector<RegressionJob> &jobs) {
+	std::ifstream fd(path);
+	if (!fd) {
+		std::cerr << "Failed to open manifest \"" << path << "\"\n";
+		return false;
+	}
+	std::string line;
+	int lineno = 0;
+	while (std::getline(fd, line)) {
+		++lineno;
+		std::istringstream ss(line);
+		RegressionJob job;
+		std::string cycles_str;
+		if (!(ss >> job.bin_path) || job.bin_path[0] == '#')
+			continue;
+		if (!(ss >> cycles_str >> job.expect_path)) {
+			std::cerr << path << ":" << lineno << ": expected <bin> <max_cycles> <expect_file>\n";
+			return false;
+		}
+		job.max_cycles = std::stol(cycles_str, 0, 0);
+		job.pass = false;
+		job.cycles = 0;
+		job.wallclock = 0;
+		jobs.push_back(job);
+	}
+	return true;
+}
+
+static void run_regression_job(RegressionJob &job) {
+	host_clock::time_point t_start = host_clock::now();
+
+	std::vector<uint8_t> expect_data;
+	if (!read_bin(job.expect_path, expect_data)) {
+		job.err = "can't open " + job.expect_path;
+		return;
+	}
+	std::string expect(expect_data.begin(), expect_data.end());
+
+	SPIMem spi0;
+	if (!spi0.add_image(job.bin_path, FLASH_LOAD_ADDR)) {
+		job.err = "can't open " + job.bin_path;
+		return;
+	}
+	UARTRX uart0(CLK_HZ, UART_BAUD);
+	SDRAMModel sdram;
+	std::unique_ptr<cxxrtl_design::p_tb> top(new cxxrtl_design::p_tb);
+	std::string uart_output;
+	ClockStepper clk(RESTEP_DEFAULT, false);
+
+	top->p_uart__rx.set<bool>(true);
+	reset_design(*top);
+	int64_t cycle;
+	for (cycle = 0; cycle < job.max_cycles && !job.pass; ++cycle) {
+		clk.edge(*top, false);
+		step_sdram(*top, sdram, cycle);
+		clk.edge(*top, true);
+
+		uart0.sample(top->p_uart__tx.get<bool>(), cycle);
+		if (uart0.rx_valid()) {
+			uart_output.push_back(uart0.get_rx());
+			// Checked on every character, so a suffix match is sufficient
+			job.pass = uart_output.size() >= expect.size() && uart_output.compare(
+				uart_output.size() - expect.size(), expect.size(), expect) == 0;
+		}
+
+		step_spi(*top, spi0);
+	}
+	job.cycles = cycle;
+	if (!job.pass)
+		job.err = "expected output not seen";
+
+	job.wallclock = seconds_since(t_start);
+}
+
+static int run_regression(const std::string &manifest_path, unsigned n_jobs) {
+	std::vector<RegressionJob> jobs;
+	if (!read_manifest(manifest_path, jobs))
+		return -1;
+	if (jobs.empty()) {
+		std::cerr << "No jobs in manifest\n";
+		return -1;
+	}
+	if (n_jobs == 0)
+		n_jobs = std::max(1u, std::thread::hardware_concurrency());
+	n_jobs = std::min<size_t>(n_jobs, jobs.size());
+
+	printf("Running %zu jobs on %u threads\n", jobs.size(), n_jobs);
+	host_clock::time_point t_start = host_clock::now();
+
+	std::atomic<size_t> next_job(0);
+	std::mutex print_mutex;
+	std::vector<std::thread> workers;
+	for (unsigned i = 0; i < n_jobs; ++i) {
+		workers.emplace_back([&]() {
+			size_t j;
+			while ((j = next_job++) < jobs.size()) {
+				RegressionJob &job = jobs[j];
+				run_regression_job(job);
+				std::lock_guard<std::mutex> lock(print_mutex);
+				printf("%s %12ld cycles %8.2f s  %s%s%s\n",
+					job.pass ? "PASS" : "FAIL", (long)job.cycles, job.wallclock,
+					job.bin_path.c_str(), job.pass ? "" : ": ", job.err.c_str());
+				fflush(stdout);
+			}
+		});
+	}
+	for (auto &w : workers)
+		w.join();
+
+	double wallclock = seconds_since(t_start);
+	size_t n_pass = 0;
+	int64_t total_cycles = 0;
+	double total_job_time = 0;
+	for (auto &job : jobs) {
+		n_pass += job.pass;
+		total_cycles += job.cycles;
+		total_job_time += job.wallclock;
+	}
+	printf("\n%zu/%zu passed, %zu failed\n", n_pass, jobs.size(), jobs.size() - n_pass);
+	printf("%ld cycles in %.2f s wallclock (%.2f s summed over jobs, %.0f cycles/s aggregate)\n",
+		(long)total_cycles, wallclock, total_job_time, wallclock > 0 ? total_cycles / wallclock : 0.0);
+	return n_pass == jobs.size() ? 0 : 1;
+}
+
 // -----------------------------------------------------------------------------
 
 const char *help_str =
-"Usage: tb [--bin x.bin] [--vcd x.vcd] [--dump start end] [--cycles n] [--port n]\n"
+"Usage: tb [--bin x.bin] [--flash x.bin@addr] [--vcd x.vcd] [--dump start end] [--cycles n] [--port n]\n"
+"          [--lockstep] [--uart-in file] [--progress n] [--profile]\n"
+"          [--restep always|auto|never] [--vcd-window start end]\n"
+"          [--vcd-trigger signal lo hi] [--vcd-scope scope]\n"
+"          [--save-state file] [--load-state file]\n"
+"          [--sdram-load file@addr] [--tcm-load file@addr] [--boot-sdram]\n"
+"          [--sdram-check] [--sdram-time x] [--sdram-refresh n] [--sdram-stats]\n"
+"          [--cache-stats]\n"
+"       tb --manifest jobs.txt [--jobs n]\n"
 "    --bin x.bin      : Flat binary file loaded to address 0x100000 in flash\n"
-"    --vcd x.vcd      : Path to dump waveforms to\n"
+"    --flash x.bin@addr : Flat binary file loaded to address addr in flash.\n"
+"                       Can be passed multiple times. Files are mapped, not\n"
+"                       copied, so size does not matter.\n"
+"    --sdram-load file@addr : Write file directly into the SDRAM model at\n"
+"                       system address addr, before reset. Can be passed\n"
+"                       multiple times.\n"
+"    --tcm-load file@addr : Write file directly into both cores' TCMs at\n"
+"                       address addr, before reset. Can be passed multiple\n"
+"                       times.\n"
+"    --boot-sdram     : Present an empty image in flash, so the bootloader\n"
+"                       skips the flash copy and jumps straight to SDRAM\n"
+"                       base + 0x40. Use with --sdram-load.\n"
+"    --sdram-check    : Check every SDRAM command against the controller\n"
+"                       timings and the SDRAM bank state, and report\n"
+"                       violations.\n"
+"    --sdram-time x   : Controller TIME register value, for --sdram-check and\n"
+"                       --sdram-stats. Default is the value sdram_init_seq()\n"
+"                       programs.\n"
+"    --sdram-refresh n : Controller REFRESH register value. Default is the\n"
+"                       value sdram_init_seq() programs.\n"
+"    --cache-stats    : Print per-core shared cache miss rates at exit. Slows\n"
+"                       the simulation a little.\n"
+"    --sdram-stats    : Print SDRAM row hit rate, refresh overhead,\n"
+"                       bandwidth, and the cost of closing rows after each\n"
+"                       access, at exit.\n"
+"    --vcd x.vcd      : Path to dump waveforms to. If the path ends in .gz,\n"
+"                       output is gzip-compressed.\n"
+"    --vcd-window start end : Only dump waveforms for cycles in [start, end).\n"
+"    --vcd-trigger signal lo hi : Don't start dumping waveforms until signal\n"
+"                       value is in the range [lo, hi], e.g. a PC range or an\n"
+"                       address on one of the AHB buses. Hierarchy separator\n"
+"                       is '.', e.g. soc_u.cpu0_haddr\n"
+"    --vcd-scope scope : Only dump signals in this scope, e.g. soc_u.cache_u.\n"
+"                       Can be passed multiple times.\n"
 "    --dump start end : Print out memory contents from start to end (exclusive)\n"
 "                       after execution finishes. Can be passed multiple times.\n"
 "    --cycles n       : Maximum number of cycles to run before exiting.\n"
 "                       Default is 0 (no maximum).\n"
+"    --save-state file : Save full simulation state to file at exit.\n"
+"    --load-state file : Start from a state saved with --save-state, instead\n"
+"                       of from reset. --cycles then counts from the restored\n"
+"                       cycle. --bin must still be passed if the flash image\n"
+"                       is needed after this point.\n"
 "    --port n         : Port number to listen for openocd remote bitbang. Sim\n"
-"                       runs in lockstep with JTAG bitbang, not free-running.\n"
+"                       free-runs, and JTAG commands are applied as they arrive.\n"
+"    --lockstep       : With --port, run sim in lockstep with JTAG bitbang\n"
+"                       instead of free-running. Much slower, but gives\n"
+"                       consistent simulation traces.\n"
+"    --uart-in file   : Send contents of file to the UART RX pin, at the\n"
+"                       simulated baud rate. Pass - to read from stdin.\n"
+"    --progress n     : Print simulation speed every n cycles.\n"
+"    --profile        : Report breakdown of host time spent in RTL evaluation,\n"
+"                       waveform dumping, peripheral models and socket I/O.\n"
+"                       Adds some overhead of its own.\n"
+"    --restep mode    : Whether to step() twice per clock edge, to work around\n"
+"                       github.com/YosysHQ/yosys/issues/2780. \"auto\" checks\n"
+"                       whether this is needed for the first few hundred\n"
+"                       thousand clock edges, then only spot-checks, and\n"
+"                       goes back to always if a check fails. Default is\n"
+"                       always, or never if built with\n"
+"                       CXXRTL_ISSUE_2780_FIXED.\n"
+"    --manifest f     : Batch regression mode. Each line of f is:\n"
+"                       <flash bin> <max cycles> <expected UART output file>\n"
+"                       Jobs run in parallel, and a pass/fail summary is\n"
+"                       printed. Exit code is nonzero if any job failed.\n"
+"    --jobs n         : Number of worker threads for --manifest. Default is\n"
+"                       the number of host CPUs.\n"
 ;
 
 void exit_help(std::string errtext = "") {
@@ -208,8 +1471,6 @@ void exit_help(std::string errtext = "") {
 	exit(-1);
 }
 
-static const int TCP_BUF_SIZE = 256;
-
 int main(int argc, char **argv) {
 
 	bool load_bin = false;
@@ -219,6 +1480,30 @@ int main(int argc, char **argv) {
 	std::vector<std::pair<uint32_t, uint32_t>> dump_ranges;
 	int64_t max_cycles = 0;
 	uint16_t port = 0;
+	bool lockstep = false;
+	std::string manifest_path;
+	unsigned n_jobs = 0;
+	std::string uart_in_path;
+	int64_t progress_interval = 0;
+	bool profile = false;
+	bool cache_stats = false;
+	restep_t restep = RESTEP_DEFAULT;
+	int64_t vcd_start = 0;
+	int64_t vcd_end = 0;
+	std::string vcd_trigger_name;
+	uint64_t vcd_trigger_lo = 0;
+	uint64_t vcd_trigger_hi = 0;
+	std::vector<std::string> vcd_scopes;
+	std::string save_state_path;
+	std::string load_state_path;
+	std::vector<FileLoad> flash_loads;
+	std::vector<FileLoad> sdram_loads;
+	std::vector<FileLoad> tcm_loads;
+	bool boot_sdram = false;
+	bool sdram_check = false;
+	bool sdram_stats = false;
+	uint32_t sdram_time = SDRAM_TIME_DEFAULT;
+	uint32_t sdram_refresh = SDRAM_REFRESH_DEFAULT;
 
 	for (int i = 1; i < argc; ++i) {
 		std::string s(argv[i]);
@@ -240,6 +1525,78 @@ int main(int argc, char **argv) {
 			waves_path = argv[i + 1];
 			i += 1;
 		}
+		else if (s == "--vcd-window") {
+			if (argc - i < 3)
+				exit_help("Option --vcd-window requires 2 arguments\n");
+			vcd_start = std::stol(argv[i + 1], 0, 0);
+			vcd_end = std::stol(argv[i + 2], 0, 0);
+			i += 2;
+		}
+		else if (s == "--vcd-trigger") {
+			if (argc - i < 4)
+				exit_help("Option --vcd-trigger requires 3 arguments\n");
+			vcd_trigger_name = debug_name(argv[i + 1]);
+			vcd_trigger_lo = std::stoull(argv[i + 2], 0, 0);
+			vcd_trigger_hi = std::stoull(argv[i + 3], 0, 0);
+			i += 3;
+		}
+		else if (s == "--vcd-scope") {
+			if (argc - i < 2)
+				exit_help("Option --vcd-scope requires an argument\n");
+			vcd_scopes.push_back(debug_name(argv[i + 1]) + " ");
+			i += 1;
+		}
+		else if (s == "--save-state") {
+			if (argc - i < 2)
+				exit_help("Option --save-state requires an argument\n");
+			save_state_path = argv[i + 1];
+			i += 1;
+		}
+		else if (s == "--load-state") {
+			if (argc - i < 2)
+				exit_help("Option --load-state requires an argument\n");
+			load_state_path = argv[i + 1];
+			i += 1;
+		}
+		else if (s == "--flash") {
+			if (argc - i < 2)
+				exit_help("Option --flash requires an argument\n");
+			FileLoad load;
+			if (!parse_file_load(argv[i + 1], load))
+				exit_help("Option --flash argument must be file@addr\n");
+			flash_loads.push_back(load);
+			i += 1;
+		}
+		else if (s == "--sdram-load" || s == "--tcm-load") {
+			if (argc - i < 2)
+				exit_help("Option " + s + " requires an argument\n");
+			FileLoad load;
+			if (!parse_file_load(argv[i + 1], load))
+				exit_help("Option " + s + " argument must be file@addr\n");
+			(s == "--sdram-load" ? sdram_loads : tcm_loads).push_back(load);
+			i += 1;
+		}
+		else if (s == "--boot-sdram") {
+			boot_sdram = true;
+		}
+		else if (s == "--sdram-check") {
+			sdram_check = true;
+		}
+		else if (s == "--sdram-time") {
+			if (argc - i < 2)
+				exit_help("Option --sdram-time requires an argument\n");
+			sdram_time = std::stoul(argv[i + 1], 0, 0);
+			i += 1;
+		}
+		else if (s == "--sdram-refresh") {
+			if (argc - i < 2)
+				exit_help("Option --sdram-refresh requires an argument\n");
+			sdram_refresh = std::stoul(argv[i + 1], 0, 0);
+			i += 1;
+		}
+		else if (s == "--sdram-stats") {
+			sdram_stats = true;
+		}
 		else if (s == "--dump") {
 			if (argc - i < 3)
 				exit_help("Option --dump requires 2 arguments\n");
@@ -261,20 +1618,72 @@ int main(int argc, char **argv) {
 			port = std::stol(argv[i + 1], 0, 0);
 			i += 1;
 		}
+		else if (s == "--lockstep") {
+			lockstep = true;
+		}
+		else if (s == "--uart-in") {
+			if (argc - i < 2)
+				exit_help("Option --uart-in requires an argument\n");
+			uart_in_path = argv[i + 1];
+			i += 1;
+		}
+		else if (s == "--progress") {
+			if (argc - i < 2)
+				exit_help("Option --progress requires an argument\n");
+			progress_interval = std::stol(argv[i + 1], 0, 0);
+			i += 1;
+		}
+		else if (s == "--profile") {
+			profile = true;
+		}
+		else if (s == "--cache-stats") {
+			cache_stats = true;
+		}
+		else if (s == "--restep") {
+			if (argc - i < 2)
+				exit_help("Option --restep requires an argument\n");
+			std::string mode(argv[i + 1]);
+			if (mode == "always")
+				restep = RESTEP_ALWAYS;
+			else if (mode == "auto")
+				restep = RESTEP_AUTO;
+			else if (mode == "never")
+				restep = RESTEP_NEVER;
+			else
+				exit_help("Option --restep must be one of always, auto, never\n");
+			i += 1;
+		}
+		else if (s == "--manifest") {
+			if (argc - i < 2)
+				exit_help("Option --manifest requires an argument\n");
+			manifest_path = argv[i + 1];
+			i += 1;
+		}
+		else if (s == "--jobs") {
+			if (argc - i < 2)
+				exit_help("Option --jobs requires an argument\n");
+			n_jobs = std::stoul(argv[i + 1], 0, 0);
+			i += 1;
+		}
 		else {
 			std::cerr << "Unrecognised argument " << s << "\n";
 			exit_help("");
 		}
 	}
-	if (!(load_bin || port != 0))
-		exit_help("At least one of --bin or --port must be specified.\n");
+	if (!manifest_path.empty()) {
+		if (load_bin || port != 0 || dump_waves)
+			exit_help("--manifest can't be combined with --bin, --port or --vcd.\n");
+		return run_regression(manifest_path, n_jobs);
+	}
+	if (boot_sdram && load_bin)
+		exit_help("--boot-sdram can't be combined with --bin.\n");
+	if (!(load_bin || !flash_loads.empty() || port != 0 || !load_state_path.empty() || boot_sdram))
+		exit_help("At least one of --bin, --flash, --port, --load-state or --boot-sdram must be specified.\n");
 
-	int server_fd, sock_fd;
+	int server_fd, sock_fd = -1;
 	struct sockaddr_in sock_addr;
 	int sock_opt = 1;
 	socklen_t sock_addr_len = sizeof(sock_addr);
-	char txbuf[TCP_BUF_SIZE], rxbuf[TCP_BUF_SIZE];
-	int rx_ptr = 0, rx_remaining = 0, tx_ptr = 0;
 
 	if (port != 0) {
 		server_fd = socket(AF_INET, SOCK_STREAM, 0);
@@ -314,149 +1723,218 @@ int main(int argc, char **argv) {
 		printf("Connected\n");
 	}
 
-	size_t binsize = 0;
-	uint8_t *binimg = NULL;
-
-	if (load_bin) {
-		std::ifstream fd(bin_path, std::ios::binary | std::ios::ate);
-		if (!fd){
-			std::cerr << "Failed to open \"" << bin_path << "\"\n";
+	SPIMem spi0;
+	if (load_bin)
+		flash_loads.insert(flash_loads.begin(), FileLoad{bin_path, FLASH_LOAD_ADDR});
+	for (auto &load : flash_loads) {
+		if (!spi0.add_image(load.path, load.addr)) {
+			std::cerr << "Failed to open \"" << load.path << "\"\n";
 			return -1;
 		}
-		binsize = fd.tellg();
-		fd.seekg(0, std::ios::beg);
-		binimg = new uint8_t[binsize];
-		fd.read((char*)binimg, binsize);
 	}
+	// Valid header with zero length: bootloader copies nothing, then jumps to
+	// the image already in SDRAM.
+	static const uint8_t empty_flash_image[] = {'C', 'S', 'o', 'C', 0, 0, 0, 0};
+	if (boot_sdram)
+		spi0.add_image(empty_flash_image, sizeof(empty_flash_image), FLASH_LOAD_ADDR);
+
 
-	SPIMem spi0(binimg, binsize, 0x100000u);
+	UARTRX uart0(CLK_HZ, UART_BAUD);
 
-	UARTRX uart0(BAUD_PERIOD);
+	int uart_in_fd = -1;
+	if (uart_in_path == "-") {
+		uart_in_fd = STDIN_FILENO;
+	}
+	else if (!uart_in_path.empty()) {
+		uart_in_fd = open(uart_in_path.c_str(), O_RDONLY);
+		if (uart_in_fd < 0) {
+			std::cerr << "Failed to open \"" << uart_in_path << "\"\n";
+			return -1;
+		}
+	}
+	UARTTX uart0_in(CLK_HZ, UART_BAUD, uart_in_fd);
 
+	SDRAMModel sdram;
+	sdram.set_timing(SDRAMTiming::from_regs(sdram_time, sdram_refresh));
+	if (sdram_check)
+		sdram.enable_checks();
 	cxxrtl_design::p_tb top;
 
-	std::ofstream waves_fd;
+	std::unique_ptr<RemoteBitbang> jtag;
+	if (port != 0)
+		jtag.reset(new RemoteBitbang(sock_fd, lockstep));
+
+	WaveFile waves_fd;
 	cxxrtl::vcd_writer vcd;
+	const cxxrtl::debug_item *vcd_trigger = NULL;
+	cxxrtl::debug_items all_debug_items;
 	if (dump_waves) {
-		waves_fd.open(waves_path);
-		cxxrtl::debug_items all_debug_items;
+		if (!waves_fd.open(waves_path)) {
+			std::cerr << "Failed to open \"" << waves_path << "\"\n";
+			return -1;
+		}
 		top.debug_info(all_debug_items);
 		vcd.timescale(1, "us");
-		vcd.add(all_debug_items);
+		if (vcd_scopes.empty()) {
+			vcd.add(all_debug_items);
+		}
+		else {
+			vcd.add(all_debug_items, [&](const std::string &name, const cxxrtl::debug_item &) {
+				for (auto &scope : vcd_scopes)
+					if (name.compare(0, scope.size(), scope) == 0)
+						return true;
+				return false;
+			});
+		}
+		if (!vcd_trigger_name.empty()) {
+			if (!all_debug_items.table.count(vcd_trigger_name) ||
+				all_debug_items.at(vcd_trigger_name).type == cxxrtl::debug_item::MEMORY) {
+				std::cerr << "No signal \"" << vcd_trigger_name << "\" for --vcd-trigger\n";
+				return -1;
+			}
+			vcd_trigger = &all_debug_items.at(vcd_trigger_name);
+		}
 	}
+	bool vcd_triggered = vcd_trigger == NULL;
 
-	// Reset + initial clock pulse
+	CacheStats cache;
+	if (cache_stats && !cache.init(top))
+		return -1;
 
-	top.step();
-	top.p_clk__sys.set<bool>(true);
-	top.p_tck.set<bool>(true);
-	top.step();
-	top.p_clk__sys.set<bool>(false);
-	top.p_tck.set<bool>(false);
-	top.p_trst__n.set<bool>(true);
-	top.p_rst__n__por.set<bool>(true);
-	top.step();
-	top.step(); // workaround for github.com/YosysHQ/yosys/issues/2780
+	int64_t start_cycle = 0;
+	top.p_uart__rx.set<bool>(true);
+	if (load_state_path.empty()) {
+		if (!backdoor_load(top, sdram, sdram_loads, tcm_loads))
+			return -1;
+		reset_design(top);
+	}
+	else {
+		if (!load_checkpoint(load_state_path, top, start_cycle, spi0, uart0, uart0_in, sdram)) {
+			std::cerr << "Failed to load state from \"" << load_state_path << "\"\n";
+			return -1;
+		}
+		printf("Restored state at cycle %ld\n", (long)start_cycle);
+		if (!backdoor_load(top, sdram, sdram_loads, tcm_loads))
+			return -1;
+	}
+	int64_t end_cycle = max_cycles ? start_cycle + max_cycles : 0;
 
-	for (int64_t cycle = 0; cycle < max_cycles || max_cycles == 0; ++cycle) {
-		top.p_clk__sys.set<bool>(false);
-		top.step();
-		top.step(); // workaround for github.com/YosysHQ/yosys/issues/2780
-		if (dump_waves)
-			vcd.sample(cycle * 2);
-		top.p_clk__sys.set<bool>(true);
-		top.step();
-		top.step();
+	ClockStepper clk(restep);
+
+	signal(SIGINT, handle_sigint);
+	HostProfile prof;
+	host_clock::time_point t_start = host_clock::now();
+	host_clock::time_point t_progress = t_start;
+	int64_t next_progress = start_cycle + progress_interval;
 
-		// If --port is specified, we run the simulator in lockstep with the
-		// remote bitbang commands, to get more consistent simulation traces.
-		// This slows down simulation quite a bit compared with normal
-		// free-running.
-		//
-		// Most bitbang commands complete in one cycle (e.g. TCK/TMS/TDI
-		// writes) but reads take 0 cycles, step=false.
-		bool got_exit_cmd = false;
-		bool step = false;
-		if (port != 0) {
-			while (!step) {
-				if (rx_remaining > 0) {
-					char c = rxbuf[rx_ptr++];
-					--rx_remaining;
-
-					if (c == 'r' || c == 's') {
-						top.p_trst__n.set<bool>(true);
-						step = true;
-					}
-					else if (c == 't' || c == 'u') {
-						top.p_trst__n.set<bool>(false);
-					}
-					else if (c >= '0' && c <= '7') {
-						int mask = c - '0';
-						top.p_tck.set<bool>(mask & 0x4);
-						top.p_tms.set<bool>(mask & 0x2);
-						top.p_tdi.set<bool>(mask & 0x1);
-						step = true;
-					}
-					else if (c == 'R') {
-						txbuf[tx_ptr++] = top.p_tdo.get<bool>() ? '1' : '0';
-						if (tx_ptr >= TCP_BUF_SIZE || rx_remaining == 0) {
-							send(sock_fd, txbuf, tx_ptr, 0);
-							tx_ptr = 0;
-						}
-					}
-					else if (c == 'Q') {
-						printf("OpenOCD sent quit command\n");
-						got_exit_cmd = true;
-						step = true;
-					}
-				}
-				else {
-					// Potentially the last command was not a read command, but
-					// OpenOCD is still waiting for a last response from its
-					// last command packet before it sends us any more, so now is
-					// the time to flush TX.
-					if (tx_ptr > 0) {
-						send(sock_fd, txbuf, tx_ptr, 0);
-						tx_ptr = 0;
-					}	
-					rx_ptr = 0;
-					rx_remaining = read(sock_fd, &rxbuf, TCP_BUF_SIZE);
-				}
+	int64_t cycle;
+	for (cycle = start_cycle; cycle < end_cycle || end_cycle == 0; ++cycle) {
+		if (profile)
+			prof.mark(HostProfile::MODELS);
+
+		bool dump_now = false;
+		if (dump_waves && cycle >= vcd_start && (cycle < vcd_end || vcd_end == 0)) {
+			if (!vcd_triggered) {
+				uint64_t v = debug_item_value(*vcd_trigger);
+				vcd_triggered = v >= vcd_trigger_lo && v <= vcd_trigger_hi;
 			}
+			dump_now = vcd_triggered;
 		}
 
-		if (dump_waves) {
+		clk.edge(top, false);
+		if (profile)
+			prof.mark(HostProfile::STEP);
+		step_sdram(top, sdram, cycle);
+		if (profile)
+			prof.mark(HostProfile::MODELS);
+		if (dump_now) {
+			vcd.sample(cycle * 2);
+			if (profile)
+				prof.mark(HostProfile::WAVES);
+		}
+		clk.edge(top, true);
+		if (profile)
+			prof.mark(HostProfile::STEP);
+		if (cache_stats) {
+			cache.sample();
+			if (profile)
+				prof.mark(HostProfile::MODELS);
+		}
+
+		// If --port is specified, JTAG inputs are driven from the remote
+		// bitbang socket (blocking only if --lockstep was passed)
+		if (jtag) {
+			jtag->step(top);
+			if (profile)
+				prof.mark(HostProfile::SOCKET);
+		}
+
+		if (dump_now) {
 			// The extra step() is just here to get the bus responses to line up nicely
 			// in the VCD (hopefully is a quick update)
 			top.step();
+			if (profile)
+				prof.mark(HostProfile::STEP);
 			vcd.sample(cycle * 2 + 1);
-			waves_fd << vcd.buffer;
-			vcd.buffer.clear();
+			waves_fd.write(vcd.buffer);
+			if (profile)
+				prof.mark(HostProfile::WAVES);
 		}
 
-		uart0.sample(top.p_uart__tx.get<bool>(), CLK_PERIOD);
+		uart0.sample(top.p_uart__tx.get<bool>(), cycle);
 		if (uart0.rx_valid()) {
 			putchar(uart0.get_rx());
 		}
+		top.p_uart__rx.set<bool>(uart0_in.step(cycle));
 
-		top.p_spi0__sdi.set<bool>(spi0.step(
-			top.p_spi0__cs__n.get<bool>(),
-			top.p_spi0__sclk.get<bool>(),
-			top.p_spi0__sdo.get<bool>()
-		));
+		step_spi(top, spi0);
+
+		if (cycle + 1 == next_progress) {
+			double t_now = seconds_since(t_start);
+			double t_interval = seconds_since(t_progress);
+			t_progress = host_clock::now();
+			fprintf(stderr, "[%ld cycles, %.1f s] %.0f cycles/s\n", (long)(cycle + 1), t_now,
+				t_interval > 0 ? progress_interval / t_interval : 0.0);
+			next_progress += progress_interval;
+		}
 
 		// if (memio.exit_req) {
 		// 	printf("CPU requested halt. Exit code %d\n", memio.exit_code);
 		// 	printf("Ran for %ld cycles\n", cycle + 1);
 		// 	break;
 		// }
-		if (cycle + 1 == max_cycles)
+		if (cycle + 1 == end_cycle)
 			printf("Max cycles reached\n");
-		if (got_exit_cmd)
+		if (jtag && jtag->got_exit_cmd) {
+			++cycle;
 			break;
+		}
+		if (got_sigint) {
+			printf("Interrupted\n");
+			++cycle;
+			break;
+		}
+	}
+
+	waves_fd.close();
+	fflush(stdout);
+	report_speed(stderr, cycle - start_cycle, seconds_since(t_start));
+
+	if (!save_state_path.empty()) {
+		if (save_checkpoint(save_state_path, top, cycle, spi0, uart0, uart0_in, sdram))
+			printf("Saved state at cycle %ld\n", (long)cycle);
+		else
+			std::cerr << "Failed to save state to \"" << save_state_path << "\"\n";
 	}
+	if (profile)
+		prof.report(stderr);
+	if (cache_stats)
+		cache.report(stderr);
+	if (sdram_stats)
+		sdram.report_stats(stderr, cycle - start_cycle, CLK_HZ);
 
-	close(sock_fd);
+	if (sock_fd >= 0)
+		close(sock_fd);
 
 	// for (auto r : dump_ranges) {
 	// 	printf("Dumping memory from %08x to %08x:\n", r.first, r.second);
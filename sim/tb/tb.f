@@ -1,3 +1,2 @@
 file tb.v
-file sdram_model.v
 list $HDL/soc/soc.f
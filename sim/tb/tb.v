@@ -3,11 +3,16 @@
 |                     SPDX-License-Identifier: Apache-2.0                     |
 \*****************************************************************************/
 
-// Nothing much to see here. Possibly a synthesisable SDRAM model soon.
+// Nothing much to see here. The SDRAM itself is modelled in C++ (see
+// sdram_model.h), attached to the sdram_* ports.
 
 `default_nettype none
 
-module tb (
+module tb #(
+	// Set from the Makefile, e.g. make CACHE_N_WAYS=2 SDRAM_CTRL=OPEN_PAGE
+	parameter CACHE_N_WAYS = 2,
+	parameter SDRAM_CTRL   = "LIBFPGA"
+) (
 	input  wire                       clk_sys,
 	input  wire                       rst_n_por,
 
@@ -23,7 +28,20 @@ module tb (
 	output wire                       spi0_sclk,
 	output wire                       spi0_cs_n,
 	output wire                       spi0_sdo,
-	input  wire                       spi0_sdi
+	input  wire                       spi0_sdi,
+
+	// Regular SDRAM interface, but with DQs replaced with separate D/Q buses
+	// to avoid using tristate logic
+	output wire [1:0]                 sdram_ba,
+	output wire [12:0]                sdram_a,
+	output wire [1:0]                 sdram_dqm,
+	output reg  [15:0]                sdram_dq_o,
+	input  wire [15:0]                sdram_dq_i,
+	output wire                       sdram_clke,
+	output wire                       sdram_cs_n,
+	output wire                       sdram_ras_n,
+	output wire                       sdram_cas_n,
+	output wire                       sdram_we_n
 );
 
 localparam W_SDRAM_BANKSEL = 2;
@@ -51,7 +69,9 @@ christmas_soc #(
 	.DTM_TYPE         ("JTAG"),
 	.TCM_SIZE_BYTES   (4096),
 	.TCM_PRELOAD_FILE ("bootloader32.hex"),
-	.CACHE_SIZE_BYTES (4096)
+	.CACHE_SIZE_BYTES (4096),
+	.CACHE_N_WAYS     (CACHE_N_WAYS),
+	.SDRAM_CTRL       (SDRAM_CTRL)
 ) soc_u (
 	.clk_sys              (clk_sys),
 	.rst_n_por            (rst_n_por),
@@ -86,21 +106,7 @@ christmas_soc #(
 
 // ----------------------------------------------------------------------------
 
-// Regular SDRAM interface, but with DQs replaced with separate D/Q buses to
-// avoid using tristate logic
 wire                       sdram_clk;
-wire [W_SDRAM_BANKSEL-1:0] sdram_ba;
-wire [W_SDRAM_ADDR-1:0]    sdram_a;
-wire [W_SDRAM_DATA/8-1:0]  sdram_dqm;
-
-reg  [W_SDRAM_DATA-1:0]    sdram_dq_o;
-wire [W_SDRAM_DATA-1:0]    sdram_dq_i;
-
-wire                       sdram_clke;
-wire                       sdram_cs_n;
-wire                       sdram_ras_n;
-wire                       sdram_cas_n;
-wire                       sdram_we_n;
 
 // Remember, "synthesisable", not synthesisable
 assign sdram_clk = !clk_sys && sdram_phy_clk_enable;
@@ -164,30 +170,6 @@ end
 
 assign sdram_phy_dq_i = dq_i_pos;
 
-// ----------------------------------------------------------------------------
-
-sdram_model #(
-	.W_BANKSEL   (W_SDRAM_BANKSEL),
-	.W_ADDR      (W_SDRAM_ADDR),
-	.W_DATA      (W_SDRAM_DATA),
-	.W_ROW       (13),
-	.W_COL       (10),
-	.CAS_LATENCY (2),
-	.BURST_LEN   (8)
-) sdram (
-	.clk_sys     (clk_sys),
-	.sdram_ba    (sdram_ba),
-	.sdram_a     (sdram_a),
-	.sdram_dqm   (sdram_dqm),
-	.sdram_dq_o  (sdram_dq_o),
-	.sdram_dq_i  (sdram_dq_i),
-	.sdram_clke  (sdram_clke),
-	.sdram_cs_n  (sdram_cs_n),
-	.sdram_ras_n (sdram_ras_n),
-	.sdram_cas_n (sdram_cas_n),
-	.sdram_we_n  (sdram_we_n)
-);
-
 endmodule
 
 `ifndef YOSYS
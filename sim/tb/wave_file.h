@@ -0,0 +1,121 @@
+#ifndef _WAVE_FILE_H
+#define _WAVE_FILE_H
+
+// Waveform output file. Text from the VCD writer is batched into large
+// chunks, and handed to a background thread which does the actual file
+// writes, so the simulation loop never waits on the disk (unless it gets
+// more than a few chunks ahead). If the path ends in .gz the output is
+// gzip-compressed, which shrinks VCD by an order of magnitude. GTKWave can
+// open .vcd.gz files directly.
+
+#include <cstdio>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include <zlib.h>
+
+class WaveFile {
+
+	static const size_t CHUNK_SIZE = 1 << 20;
+	static const size_t MAX_PENDING_CHUNKS = 8;
+
+	FILE *fd;
+	gzFile gz;
+
+	std::string buf;
+	std::deque<std::string> pending;
+	std::mutex mutex;
+	std::condition_variable cv_pending;
+	std::condition_variable cv_space;
+	bool closing;
+	std::thread writer;
+
+	void writer_main() {
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true) {
+			cv_pending.wait(lock, [this]{return closing || !pending.empty();});
+			if (pending.empty())
+				break;
+			std::string chunk(std::move(pending.front()));
+			pending.pop_front();
+			cv_space.notify_one();
+			lock.unlock();
+			if (gz)
+				gzwrite(gz, chunk.data(), chunk.size());
+			else
+				fwrite(chunk.data(), 1, chunk.size(), fd);
+			lock.lock();
+		}
+	}
+
+	void submit_chunk() {
+		std::unique_lock<std::mutex> lock(mutex);
+		cv_space.wait(lock, [this]{return pending.size() < MAX_PENDING_CHUNKS;});
+		pending.push_back(std::move(buf));
+		buf.clear();
+		buf.reserve(CHUNK_SIZE);
+		cv_pending.notify_one();
+	}
+
+public:
+
+	WaveFile() {
+		fd = NULL;
+		gz = NULL;
+		closing = false;
+	}
+
+	~WaveFile() {
+		close();
+	}
+
+	bool open(const std::string &path) {
+		bool compress = path.size() > 3 && path.compare(path.size() - 3, 3, ".gz") == 0;
+		if (compress) {
+			// Level 1: most of the size reduction, for a fraction of the time
+			gz = gzopen(path.c_str(), "wb1");
+			if (!gz)
+				return false;
+		}
+		else {
+			fd = fopen(path.c_str(), "wb");
+			if (!fd)
+				return false;
+		}
+		buf.reserve(CHUNK_SIZE);
+		writer = std::thread(&WaveFile::writer_main, this);
+		return true;
+	}
+
+	// Consumes (clears) the contents of data.
+	void write(std::string &data) {
+		buf += data;
+		data.clear();
+		if (buf.size() >= CHUNK_SIZE)
+			submit_chunk();
+	}
+
+	void close() {
+		if (!writer.joinable())
+			return;
+		if (!buf.empty())
+			submit_chunk();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			closing = true;
+		}
+		cv_pending.notify_one();
+		writer.join();
+		if (gz)
+			gzclose(gz);
+		if (fd)
+			fclose(fd);
+		gz = NULL;
+		fd = NULL;
+	}
+};
+
+#endif // _WAVE_FILE_H
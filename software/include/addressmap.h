@@ -13,12 +13,18 @@
 #define SDRAM_BASE _u(0x08000000)
 #define SDRAM_SIZE _u(0x04000000)
 #define PERI_BASE  _u(0x0c000000)
+#define XIP_BASE   _u(0x0e000000)
+#define XIP_SIZE   _u(0x01000000)
 
 #define UART_BASE       (PERI_BASE + _u(0x0000))
 #define SPI_BASE        (PERI_BASE + _u(0x1000))
 #define SDRAM_CTRL_BASE (PERI_BASE + _u(0x2000))
 #define TIMER_BASE      (PERI_BASE + _u(0x3000))
 #define GPIO_BASE       (PERI_BASE + _u(0x4000))
+#define PERF_BASE       (PERI_BASE + _u(0x5000))
+#define CACHECTRL_BASE  (PERI_BASE + _u(0x6000))
+#define DMA_BASE        (PERI_BASE + _u(0x7000))
+#define XIP_CTRL_BASE   (PERI_BASE + _u(0x8000))
 
 #ifndef __ASSEMBLER__
 
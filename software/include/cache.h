@@ -0,0 +1,158 @@
+#ifndef _CACHE_H
+#define _CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "addressmap.h"
+#include "hw/cachectrl_regs.h"
+
+// The shared cache is write-back, and has no maintenance port of its own.
+// Instead, lines are cleaned and evicted by reading other addresses which
+// map to the same cache set, so the replacement policy pushes out the target
+// lines (writing them back if dirty). The alias reads come from a region at
+// the top of SDRAM which the linker script keeps free.
+//
+// So, every operation on the shared cache both cleans and evicts. In
+// particular "invalidate" writes back dirty data before dropping the line,
+// rather than discarding it. Invalidate before handing a buffer to another
+// bus master, and don't touch it until the master has finished.
+//
+// The replacement policy is internal to the cache, so the number of alias
+// reads needed isn't assumed. Instead, one alias per way is read, and the
+// reads are repeated until a whole pass causes no line fills, as counted by
+// the EVICT_FILLS register. All ways of the set then hold alias lines, so the
+// target line must have been evicted, whatever the policy. With LRU or
+// round-robin replacement this takes two passes; with random replacement it
+// may take a few more. The eviction region must be at least the cache size,
+// so this supports caches up to 64K.
+//
+// Other masters can still bring a line back in at any time, so don't access
+// the range from elsewhere during maintenance.
+//
+// The per-core instruction caches already snoop all writes on the shared
+// bus, so only need explicit invalidation for writes which bypass it.
+
+typedef struct cachectrl_hw {
+	io_ro_32 geometry;
+	io_wo_32 icache_inval;
+	io_ro_32 evict_fills;
+} cachectrl_hw_t;
+
+#define mm_cachectrl ((cachectrl_hw_t*)CACHECTRL_BASE)
+
+#define CACHE_EVICT_SIZE _u(0x10000)
+#define CACHE_EVICT_BASE (SDRAM_BASE + SDRAM_SIZE - CACHE_EVICT_SIZE)
+
+// ----------------------------------------------------------------------------
+// Geometry
+
+static inline uint32_t cache_size(void) {
+	return 1u << ((mm_cachectrl->geometry & CACHECTRL_GEOMETRY_SIZE_LOG2_MASK) >> CACHECTRL_GEOMETRY_SIZE_LOG2_LSB);
+}
+
+static inline uint32_t cache_ways(void) {
+	return 1u << ((mm_cachectrl->geometry & CACHECTRL_GEOMETRY_WAYS_LOG2_MASK) >> CACHECTRL_GEOMETRY_WAYS_LOG2_LSB);
+}
+
+static inline uint32_t cache_line_size(void) {
+	return 1u << ((mm_cachectrl->geometry & CACHECTRL_GEOMETRY_LINE_LOG2_MASK) >> CACHECTRL_GEOMETRY_LINE_LOG2_LSB);
+}
+
+static inline uint32_t cache_n_sets(void) {
+	return cache_size() / (cache_ways() * cache_line_size());
+}
+
+// ----------------------------------------------------------------------------
+// Shared cache maintenance
+
+// Evict the set containing byte offset `offs` within a cache way, by reading
+// one alias per way until a pass causes no fills.
+static inline void _cache_evict_offs(uint32_t offs, uint32_t way_size, uint32_t ways) {
+	uint32_t fills;
+	do {
+		fills = mm_cachectrl->evict_fills;
+		for (uint32_t i = 0; i < ways; ++i)
+			(void)*(io_ro_32*)(CACHE_EVICT_BASE + i * way_size + offs);
+	} while (mm_cachectrl->evict_fills != fills);
+}
+
+// Clean and evict every line in the cache.
+static inline void cache_flush_all(void) {
+	asm volatile ("" : : : "memory");
+	uint32_t line = cache_line_size();
+	uint32_t end = CACHE_EVICT_BASE + cache_size();
+	uint32_t fills;
+	do {
+		fills = mm_cachectrl->evict_fills;
+		for (uintptr_t addr = CACHE_EVICT_BASE; addr < end; addr += line)
+			(void)*(io_ro_32*)addr;
+	} while (mm_cachectrl->evict_fills != fills);
+	asm volatile ("" : : : "memory");
+}
+
+// Set/way operation: clean and evict all ways of one set.
+static inline void cache_flush_set(uint32_t set) {
+	asm volatile ("" : : : "memory");
+	uint32_t ways = cache_ways();
+	uint32_t line = cache_line_size();
+	_cache_evict_offs(set * line, cache_size() / ways, ways);
+	asm volatile ("" : : : "memory");
+}
+
+static inline void _cache_flush_region(uintptr_t start, uintptr_t end, uintptr_t base, uint32_t size) {
+	if (start < base)
+		start = base;
+	if (end > base + size)
+		end = base + size;
+	if (start >= end)
+		return;
+	uint32_t cache_bytes = cache_size();
+	if (end - start >= cache_bytes) {
+		cache_flush_all();
+		return;
+	}
+	asm volatile ("" : : : "memory");
+	uint32_t ways = cache_ways();
+	uint32_t line = cache_line_size();
+	uint32_t way_size = cache_bytes / ways;
+	for (uintptr_t a = start & ~(uintptr_t)(line - 1); a < end; a += line)
+		_cache_evict_offs(a & (way_size - 1), way_size, ways);
+	asm volatile ("" : : : "memory");
+}
+
+// Clean and evict all lines overlapping [addr, addr + len). Only SDRAM and the
+// XIP window are cached, so other addresses are ignored. Writes to the XIP
+// window are faulted before they reach the cache, so XIP lines are never
+// dirty, and for XIP addresses this just drops any stale copies, e.g. after
+// reprogramming flash.
+static inline void cache_flush_range(const volatile void *addr, size_t len) {
+	uintptr_t start = (uintptr_t)addr;
+	uintptr_t end = start + len;
+	_cache_flush_region(start, end, SDRAM_BASE, SDRAM_SIZE);
+	_cache_flush_region(start, end, XIP_BASE, XIP_SIZE);
+}
+
+// Write back dirty data in the range, e.g. before another master reads it.
+static inline void cache_clean_range(const volatile void *addr, size_t len) {
+	cache_flush_range(addr, len);
+}
+
+// Remove the range from the cache, e.g. before another master writes it.
+// Dirty data is written back first, not discarded.
+static inline void cache_invalidate_range(const volatile void *addr, size_t len) {
+	cache_flush_range(addr, len);
+}
+
+// ----------------------------------------------------------------------------
+// Instruction cache maintenance
+
+static inline void icache_invalidate(int core) {
+	mm_cachectrl->icache_inval = 1u << core;
+}
+
+static inline void icache_invalidate_all(void) {
+	mm_cachectrl->icache_inval = CACHECTRL_ICACHE_INVAL_MASK;
+}
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef _DMA_H_
+#define _DMA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "addressmap.h"
+#include "hw/dma_regs.h"
+#include "spi.h"
+#include "hw/uart_regs.h"
+
+#define DMA_N_CHANNELS 2
+
+typedef struct dma_ch_hw {
+	io_rw_32 read_addr;
+	io_rw_32 write_addr;
+	io_rw_32 count;
+	io_rw_32 ctrl;
+	io_rw_32 pace_addr;
+	io_rw_32 pace_mask;
+	io_rw_32 pace_match;
+} dma_ch_hw_t;
+
+typedef struct dma_hw {
+	dma_ch_hw_t ch[DMA_N_CHANNELS];
+	io_rw_32 intr;
+} dma_hw_t;
+
+#define mm_dma ((dma_hw_t*)DMA_BASE)
+
+// The two channels have identical register layouts
+#define DMA_CTRL_EN_MASK         DMA_CH0_CTRL_EN_MASK
+#define DMA_CTRL_SIZE_LSB        DMA_CH0_CTRL_SIZE_LSB
+#define DMA_CTRL_INCR_READ_MASK  DMA_CH0_CTRL_INCR_READ_MASK
+#define DMA_CTRL_INCR_WRITE_MASK DMA_CH0_CTRL_INCR_WRITE_MASK
+#define DMA_CTRL_PACE_MASK       DMA_CH0_CTRL_PACE_MASK
+#define DMA_CTRL_IRQ_EN_MASK     DMA_CH0_CTRL_IRQ_EN_MASK
+#define DMA_CTRL_READ_ZERO_MASK  DMA_CH0_CTRL_READ_ZERO_MASK
+#define DMA_CTRL_BUSY_MASK       DMA_CH0_CTRL_BUSY_MASK
+#define DMA_CTRL_ERR_MASK        DMA_CH0_CTRL_ERR_MASK
+
+enum dma_size {
+	DMA_SIZE_8  = 0,
+	DMA_SIZE_16 = 1,
+	DMA_SIZE_32 = 2
+};
+
+// A channel's transfers go through the system cache, the same as the cores',
+// so no cache maintenance is needed before or after a transfer. The DMA's
+// writes to code are also seen by the instruction caches.
+//
+// The DMA can't reach either core's TCM, which includes the stack and
+// anything marked __tcm. A transfer to or from an address below SDRAM_BASE
+// stops the channel with an error (see dma_error()).
+
+typedef struct dma_config {
+	const volatile void *read_addr;
+	volatile void *write_addr;
+	uint32_t count;
+	enum dma_size size;
+	bool incr_read;
+	bool incr_write;
+	bool irq_en;
+	// Skip the reads, and write zeroes. read_addr is ignored.
+	bool read_zero;
+	// If pace_addr is non-NULL, the channel reads it before each transfer, and
+	// only proceeds if (value & pace_mask) == pace_match.
+	const volatile void *pace_addr;
+	uint32_t pace_mask;
+	uint32_t pace_match;
+} dma_config_t;
+
+static inline bool dma_busy(int ch) {
+	return !!(mm_dma->ch[ch].ctrl & DMA_CTRL_BUSY_MASK);
+}
+
+static inline void dma_wait(int ch) {
+	while (dma_busy(ch))
+		;
+}
+
+// True if the channel stopped early due to a bus error, or an address the
+// DMA can't reach. Cleared by dma_start().
+static inline bool dma_error(int ch) {
+	return !!(mm_dma->ch[ch].ctrl & DMA_CTRL_ERR_MASK);
+}
+
+static inline void dma_abort(int ch) {
+	mm_dma->ch[ch].ctrl &= ~(DMA_CTRL_EN_MASK | DMA_CTRL_ERR_MASK);
+	mm_dma->ch[ch].count = 0;
+}
+
+// Returns with the channel running. The channel must not already be busy.
+static inline void dma_start(int ch, const dma_config_t *cfg) {
+	dma_ch_hw_t *hw = &mm_dma->ch[ch];
+	hw->ctrl = DMA_CTRL_ERR_MASK;
+	hw->read_addr = (uintptr_t)cfg->read_addr;
+	hw->write_addr = (uintptr_t)cfg->write_addr;
+	hw->pace_addr = (uintptr_t)cfg->pace_addr;
+	hw->pace_mask = cfg->pace_mask;
+	hw->pace_match = cfg->pace_match;
+	hw->count = cfg->count;
+	mm_dma->intr = 1u << ch;
+	hw->ctrl = DMA_CTRL_EN_MASK |
+		((uint32_t)cfg->size << DMA_CTRL_SIZE_LSB) |
+		(cfg->incr_read  ? DMA_CTRL_INCR_READ_MASK  : 0) |
+		(cfg->incr_write ? DMA_CTRL_INCR_WRITE_MASK : 0) |
+		(cfg->pace_addr  ? DMA_CTRL_PACE_MASK       : 0) |
+		(cfg->irq_en     ? DMA_CTRL_IRQ_EN_MASK     : 0) |
+		(cfg->read_zero  ? DMA_CTRL_READ_ZERO_MASK  : 0);
+}
+
+// Interrupt flags are set when a channel's count reaches zero. Channels with
+// irq_en set assert the DMA IRQ (external IRQ 1) while their flag is set.
+static inline bool dma_irq_pending(int ch) {
+	return !!(mm_dma->intr & (1u << ch));
+}
+
+static inline void dma_irq_clear(int ch) {
+	mm_dma->intr = 1u << ch;
+}
+
+// Non-blocking copy: use dma_wait() before touching either buffer. Uses word
+// transfers when both pointers and the length are word-aligned. Neither
+// buffer may be in TCM, so not on the stack.
+static inline void dma_memcpy_start(int ch, void *dst, const void *src, size_t len) {
+	enum dma_size size = DMA_SIZE_8;
+	if (!(((uintptr_t)dst | (uintptr_t)src | len) & 0x3u))
+		size = DMA_SIZE_32;
+	else if (!(((uintptr_t)dst | (uintptr_t)src | len) & 0x1u))
+		size = DMA_SIZE_16;
+	dma_config_t cfg = {
+		.read_addr = src,
+		.write_addr = dst,
+		.count = len >> size,
+		.size = size,
+		.incr_read = true,
+		.incr_write = true
+	};
+	dma_start(ch, &cfg);
+}
+
+static inline void dma_memcpy(int ch, void *dst, const void *src, size_t len) {
+	dma_memcpy_start(ch, dst, src, len);
+	dma_wait(ch);
+}
+
+// Stream bytes to the UART, pushing only while its TX FIFO has space.
+static inline void dma_uart_tx_start(int ch, const uint8_t *src, size_t len) {
+	dma_config_t cfg = {
+		.read_addr = src,
+		.write_addr = (void*)(UART_BASE + UART_TX_OFFS),
+		.count = len,
+		.size = DMA_SIZE_8,
+		.incr_read = true,
+		.pace_addr = (void*)(UART_BASE + UART_FSTAT_OFFS),
+		.pace_mask = UART_FSTAT_TXFULL_MASK,
+		.pace_match = 0
+	};
+	dma_start(ch, &cfg);
+}
+
+// Receive len bytes from the SPI into memory, using both channels: channel 0
+// feeds zeroes to the TX FIFO, and channel 1 empties the RX FIFO. A TX byte is only
+// pushed when both FIFO levels are below 4, so there are at most 8 bytes in
+// flight (3 + 1 in the shifter + 3, plus the new byte), which the RX FIFO can
+// hold whatever order the channels get serviced in. Chip select is left to
+// the caller.
+#if SPI_FIFO_DEPTH < 8
+#error "dma_spi_read() pacing assumes an SPI FIFO depth of at least 8"
+#endif
+
+static inline void dma_spi_read_start(uint8_t *dst, size_t len) {
+	while (!(*(io_ro_32*)(SPI_BASE + SPI_FSTAT_OFFS) & SPI_FSTAT_RXEMPTY_MASK))
+		(void)*(io_ro_32*)(SPI_BASE + SPI_RX_OFFS);
+	dma_config_t rx = {
+		.read_addr = (void*)(SPI_BASE + SPI_RX_OFFS),
+		.write_addr = dst,
+		.count = len,
+		.size = DMA_SIZE_8,
+		.incr_write = true,
+		.pace_addr = (void*)(SPI_BASE + SPI_FSTAT_OFFS),
+		.pace_mask = SPI_FSTAT_RXEMPTY_MASK,
+		.pace_match = 0
+	};
+	dma_config_t tx = {
+		.write_addr = (void*)(SPI_BASE + SPI_TX_OFFS),
+		.count = len,
+		.size = DMA_SIZE_8,
+		.read_zero = true,
+		.pace_addr = (void*)(SPI_BASE + SPI_FSTAT_OFFS),
+		.pace_mask = (SPI_FSTAT_TXLEVEL_MASK | SPI_FSTAT_RXLEVEL_MASK) &
+			~(0x3u << SPI_FSTAT_TXLEVEL_LSB | 0x3u << SPI_FSTAT_RXLEVEL_LSB),
+		.pace_match = 0
+	};
+	dma_start(1, &rx);
+	dma_start(0, &tx);
+}
+
+// Returns false if either channel stopped on a bus error. The other channel
+// would then never finish (each is paced by the other's FIFO), so both are
+// aborted, and the SPI FIFOs may have leftover data.
+static inline bool dma_spi_read(uint8_t *dst, size_t len) {
+	dma_spi_read_start(dst, len);
+	while (dma_busy(1) && !dma_error(0) && !dma_error(1))
+		;
+	if (dma_error(0) || dma_error(1)) {
+		dma_abort(0);
+		dma_abort(1);
+		return false;
+	}
+	return true;
+}
+
+#endif // _DMA_H_
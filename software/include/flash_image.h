@@ -0,0 +1,51 @@
+#ifndef _FLASH_IMAGE_H_
+#define _FLASH_IMAGE_H_
+
+#include <stdint.h>
+
+// Boot image format, as written by scripts/mkflashbin and loaded by the
+// bootloader from flash address 0x100000. All fields are little-endian.
+//
+// The image header is followed by n_segments segments, each of which is a
+// segment header followed by stored_size bytes of data. Segments are loaded
+// in order, then the bootloader jumps to entry. When built from an ELF file,
+// there is one segment per PT_LOAD program header (split further around long
+// runs of zeroes), and zero-initialised data such as .bss is left to the C
+// runtime.
+//
+// Segment headers aren't covered by a CRC, so the bootloader rejects any
+// segment outside of SDRAM, or whose data is not exactly stored_size bytes.
+//
+// The older format, "CSoC" followed by a 32-bit length and that many bytes to
+// copy to SDRAM_BASE, is still accepted.
+
+#define FLASH_IMAGE_MAGIC   0x4d495343u // "CSIM"
+#define FLASH_IMAGE_VERSION 1u
+
+#define FLASH_IMAGE_MAGIC_LEGACY 0x436f5343u // "CSoC"
+
+typedef struct flash_image_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entry;
+	uint32_t n_segments;
+} flash_image_header_t;
+
+// Segment data is stored as-is (stored_size == size)
+#define FLASH_SEG_RAW  0u
+// Segment has no data (stored_size == 0), and is filled with zeroes
+#define FLASH_SEG_ZERO 1u
+// Segment data is a single LZ4 block (no frame), which decodes to size bytes
+#define FLASH_SEG_LZ4  2u
+
+typedef struct flash_segment_header {
+	uint32_t load_addr;
+	uint32_t size;
+	uint32_t stored_size;
+	uint32_t type;
+	// CRC-32 (as zlib/Ethernet) of the size bytes written to load_addr. Not
+	// checked for FLASH_SEG_ZERO.
+	uint32_t crc;
+} flash_segment_header_t;
+
+#endif
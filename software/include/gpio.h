@@ -74,7 +74,7 @@ static inline bool gpio_get(int gpio) {
 	return !!(mm_gpio->i & (1u << gpio));
 }
 
-static inline uint32_2 gpio_get_all(int gpio) {
+static inline uint32_t gpio_get_all() {
 	return mm_gpio->i;
 }
 
@@ -0,0 +1,65 @@
+/*******************************************************************************
+*                       REGISTER BLOCK, WRITTEN BY HAND                        *
+*        Laid out like regblock output, but not generated by regblock.         *
+*          Keep in step with cachectrl_regs.yml when editing either.           *
+*******************************************************************************/
+
+#ifndef _CACHECTRL_REGS_H_
+#define _CACHECTRL_REGS_H_
+
+// Block name           : cachectrl
+// Bus type             : apb
+// Bus data width       : 32
+// Bus address width    : 16
+
+#define CACHECTRL_GEOMETRY_OFFS 0
+#define CACHECTRL_ICACHE_INVAL_OFFS 4
+#define CACHECTRL_EVICT_FILLS_OFFS 8
+
+/*******************************************************************************
+*                                   GEOMETRY                                   *
+*******************************************************************************/
+
+// Shared cache geometry, for software cache maintenance
+
+// Field: GEOMETRY_SIZE_LOG2  Access: ROV
+// Log2 of total cache size in bytes
+#define CACHECTRL_GEOMETRY_SIZE_LOG2_LSB  0
+#define CACHECTRL_GEOMETRY_SIZE_LOG2_BITS 5
+#define CACHECTRL_GEOMETRY_SIZE_LOG2_MASK 0x1f
+// Field: GEOMETRY_WAYS_LOG2  Access: ROV
+// Log2 of number of ways
+#define CACHECTRL_GEOMETRY_WAYS_LOG2_LSB  8
+#define CACHECTRL_GEOMETRY_WAYS_LOG2_BITS 2
+#define CACHECTRL_GEOMETRY_WAYS_LOG2_MASK 0x300
+// Field: GEOMETRY_LINE_LOG2  Access: ROV
+// Log2 of line size in bytes
+#define CACHECTRL_GEOMETRY_LINE_LOG2_LSB  16
+#define CACHECTRL_GEOMETRY_LINE_LOG2_BITS 4
+#define CACHECTRL_GEOMETRY_LINE_LOG2_MASK 0xf0000
+
+/*******************************************************************************
+*                                 ICACHE_INVAL                                 *
+*******************************************************************************/
+
+// Write 1 to a bit to invalidate all lines of that core's instruction cache.
+
+// Field: ICACHE_INVAL  Access: WF
+#define CACHECTRL_ICACHE_INVAL_LSB  0
+#define CACHECTRL_ICACHE_INVAL_BITS 2
+#define CACHECTRL_ICACHE_INVAL_MASK 0x3
+
+/*******************************************************************************
+*                                 EVICT_FILLS                                  *
+*******************************************************************************/
+
+// Count of shared cache line fills from the eviction region at the top of
+// SDRAM. Software maintenance uses this to check its alias reads have filled
+// every way of a set.
+
+// Field: EVICT_FILLS  Access: ROV
+#define CACHECTRL_EVICT_FILLS_LSB  0
+#define CACHECTRL_EVICT_FILLS_BITS 32
+#define CACHECTRL_EVICT_FILLS_MASK 0xffffffff
+
+#endif // _CACHECTRL_REGS_H_
@@ -0,0 +1,280 @@
+/*******************************************************************************
+*                       REGISTER BLOCK, WRITTEN BY HAND                        *
+*        Laid out like regblock output, but not generated by regblock.         *
+*             Keep in step with dma_regs.yml when editing either.              *
+*******************************************************************************/
+
+#ifndef _DMA_REGS_H_
+#define _DMA_REGS_H_
+
+// Block name           : dma
+// Bus type             : apb
+// Bus data width       : 32
+// Bus address width    : 16
+
+#define DMA_CH0_READ_ADDR_OFFS 0
+#define DMA_CH0_WRITE_ADDR_OFFS 4
+#define DMA_CH0_COUNT_OFFS 8
+#define DMA_CH0_CTRL_OFFS 12
+#define DMA_CH0_PACE_ADDR_OFFS 16
+#define DMA_CH0_PACE_MASK_OFFS 20
+#define DMA_CH0_PACE_MATCH_OFFS 24
+#define DMA_CH1_READ_ADDR_OFFS 28
+#define DMA_CH1_WRITE_ADDR_OFFS 32
+#define DMA_CH1_COUNT_OFFS 36
+#define DMA_CH1_CTRL_OFFS 40
+#define DMA_CH1_PACE_ADDR_OFFS 44
+#define DMA_CH1_PACE_MASK_OFFS 48
+#define DMA_CH1_PACE_MATCH_OFFS 52
+#define DMA_INTR_OFFS 56
+
+/*******************************************************************************
+*                                CH0_READ_ADDR                                 *
+*******************************************************************************/
+
+// Channel 0 read address. Reads back the address of the next transfer.
+
+// Field: CH0_READ_ADDR  Access: RWF
+#define DMA_CH0_READ_ADDR_LSB  0
+#define DMA_CH0_READ_ADDR_BITS 32
+#define DMA_CH0_READ_ADDR_MASK 0xffffffff
+
+/*******************************************************************************
+*                                CH0_WRITE_ADDR                                *
+*******************************************************************************/
+
+// Channel 0 write address. Reads back the address of the next transfer.
+
+// Field: CH0_WRITE_ADDR  Access: RWF
+#define DMA_CH0_WRITE_ADDR_LSB  0
+#define DMA_CH0_WRITE_ADDR_BITS 32
+#define DMA_CH0_WRITE_ADDR_MASK 0xffffffff
+
+/*******************************************************************************
+*                                  CH0_COUNT                                   *
+*******************************************************************************/
+
+// Channel 0 number of transfers remaining. The channel is busy while this is nonzero and EN is set.
+
+// Field: CH0_COUNT  Access: RWF
+#define DMA_CH0_COUNT_LSB  0
+#define DMA_CH0_COUNT_BITS 32
+#define DMA_CH0_COUNT_MASK 0xffffffff
+
+/*******************************************************************************
+*                                   CH0_CTRL                                   *
+*******************************************************************************/
+
+// Channel 0 control and status
+
+// Field: CH0_CTRL_EN  Access: RW
+// Enable the channel. Clearing this pauses it after the current transfer.
+#define DMA_CH0_CTRL_EN_LSB  0
+#define DMA_CH0_CTRL_EN_BITS 1
+#define DMA_CH0_CTRL_EN_MASK 0x1
+// Field: CH0_CTRL_SIZE  Access: RW
+// Transfer size: 0 byte, 1 halfword, 2 word
+#define DMA_CH0_CTRL_SIZE_LSB  1
+#define DMA_CH0_CTRL_SIZE_BITS 2
+#define DMA_CH0_CTRL_SIZE_MASK 0x6
+// Field: CH0_CTRL_INCR_READ  Access: RW
+// If 1
+#define DMA_CH0_CTRL_INCR_READ_LSB  3
+#define DMA_CH0_CTRL_INCR_READ_BITS 1
+#define DMA_CH0_CTRL_INCR_READ_MASK 0x8
+// Field: CH0_CTRL_INCR_WRITE  Access: RW
+// If 1
+#define DMA_CH0_CTRL_INCR_WRITE_LSB  4
+#define DMA_CH0_CTRL_INCR_WRITE_BITS 1
+#define DMA_CH0_CTRL_INCR_WRITE_MASK 0x10
+// Field: CH0_CTRL_PACE  Access: RW
+// If 1, before each transfer, read PACE_ADDR, and only proceed if (data & PACE_MASK) == PACE_MATCH
+#define DMA_CH0_CTRL_PACE_LSB  5
+#define DMA_CH0_CTRL_PACE_BITS 1
+#define DMA_CH0_CTRL_PACE_MASK 0x20
+// Field: CH0_CTRL_IRQ_EN  Access: RW
+// Assert the DMA IRQ when this channel's INTR flag is set
+#define DMA_CH0_CTRL_IRQ_EN_LSB  6
+#define DMA_CH0_CTRL_IRQ_EN_BITS 1
+#define DMA_CH0_CTRL_IRQ_EN_MASK 0x40
+// Field: CH0_CTRL_READ_ZERO  Access: RW
+// If 1, skip the read, and write zero. READ_ADDR is ignored.
+#define DMA_CH0_CTRL_READ_ZERO_LSB  7
+#define DMA_CH0_CTRL_READ_ZERO_BITS 1
+#define DMA_CH0_CTRL_READ_ZERO_MASK 0x80
+// Field: CH0_CTRL_BUSY  Access: ROV
+// Channel is enabled and has transfers remaining
+#define DMA_CH0_CTRL_BUSY_LSB  8
+#define DMA_CH0_CTRL_BUSY_BITS 1
+#define DMA_CH0_CTRL_BUSY_MASK 0x100
+// Field: CH0_CTRL_ERR  Access: W1C
+// A bus error, or an address below SDRAM (e.g. TCM), stopped this channel.
+// COUNT has been cleared.
+#define DMA_CH0_CTRL_ERR_LSB  9
+#define DMA_CH0_CTRL_ERR_BITS 1
+#define DMA_CH0_CTRL_ERR_MASK 0x200
+
+/*******************************************************************************
+*                                CH0_PACE_ADDR                                 *
+*******************************************************************************/
+
+// Channel 0 pacing status address, e.g. a peripheral FIFO status register
+
+// Field: CH0_PACE_ADDR  Access: RW
+#define DMA_CH0_PACE_ADDR_LSB  0
+#define DMA_CH0_PACE_ADDR_BITS 32
+#define DMA_CH0_PACE_ADDR_MASK 0xffffffff
+
+/*******************************************************************************
+*                                CH0_PACE_MASK                                 *
+*******************************************************************************/
+
+// Channel 0 pacing status mask
+
+// Field: CH0_PACE_MASK  Access: RW
+#define DMA_CH0_PACE_MASK_LSB  0
+#define DMA_CH0_PACE_MASK_BITS 32
+#define DMA_CH0_PACE_MASK_MASK 0xffffffff
+
+/*******************************************************************************
+*                                CH0_PACE_MATCH                                *
+*******************************************************************************/
+
+// Channel 0 pacing status match value
+
+// Field: CH0_PACE_MATCH  Access: RW
+#define DMA_CH0_PACE_MATCH_LSB  0
+#define DMA_CH0_PACE_MATCH_BITS 32
+#define DMA_CH0_PACE_MATCH_MASK 0xffffffff
+
+/*******************************************************************************
+*                                CH1_READ_ADDR                                 *
+*******************************************************************************/
+
+// Channel 1 read address. Reads back the address of the next transfer.
+
+// Field: CH1_READ_ADDR  Access: RWF
+#define DMA_CH1_READ_ADDR_LSB  0
+#define DMA_CH1_READ_ADDR_BITS 32
+#define DMA_CH1_READ_ADDR_MASK 0xffffffff
+
+/*******************************************************************************
+*                                CH1_WRITE_ADDR                                *
+*******************************************************************************/
+
+// Channel 1 write address. Reads back the address of the next transfer.
+
+// Field: CH1_WRITE_ADDR  Access: RWF
+#define DMA_CH1_WRITE_ADDR_LSB  0
+#define DMA_CH1_WRITE_ADDR_BITS 32
+#define DMA_CH1_WRITE_ADDR_MASK 0xffffffff
+
+/*******************************************************************************
+*                                  CH1_COUNT                                   *
+*******************************************************************************/
+
+// Channel 1 number of transfers remaining. The channel is busy while this is nonzero and EN is set.
+
+// Field: CH1_COUNT  Access: RWF
+#define DMA_CH1_COUNT_LSB  0
+#define DMA_CH1_COUNT_BITS 32
+#define DMA_CH1_COUNT_MASK 0xffffffff
+
+/*******************************************************************************
+*                                   CH1_CTRL                                   *
+*******************************************************************************/
+
+// Channel 1 control and status
+
+// Field: CH1_CTRL_EN  Access: RW
+// Enable the channel. Clearing this pauses it after the current transfer.
+#define DMA_CH1_CTRL_EN_LSB  0
+#define DMA_CH1_CTRL_EN_BITS 1
+#define DMA_CH1_CTRL_EN_MASK 0x1
+// Field: CH1_CTRL_SIZE  Access: RW
+// Transfer size: 0 byte, 1 halfword, 2 word
+#define DMA_CH1_CTRL_SIZE_LSB  1
+#define DMA_CH1_CTRL_SIZE_BITS 2
+#define DMA_CH1_CTRL_SIZE_MASK 0x6
+// Field: CH1_CTRL_INCR_READ  Access: RW
+// If 1
+#define DMA_CH1_CTRL_INCR_READ_LSB  3
+#define DMA_CH1_CTRL_INCR_READ_BITS 1
+#define DMA_CH1_CTRL_INCR_READ_MASK 0x8
+// Field: CH1_CTRL_INCR_WRITE  Access: RW
+// If 1
+#define DMA_CH1_CTRL_INCR_WRITE_LSB  4
+#define DMA_CH1_CTRL_INCR_WRITE_BITS 1
+#define DMA_CH1_CTRL_INCR_WRITE_MASK 0x10
+// Field: CH1_CTRL_PACE  Access: RW
+// If 1, before each transfer, read PACE_ADDR, and only proceed if (data & PACE_MASK) == PACE_MATCH
+#define DMA_CH1_CTRL_PACE_LSB  5
+#define DMA_CH1_CTRL_PACE_BITS 1
+#define DMA_CH1_CTRL_PACE_MASK 0x20
+// Field: CH1_CTRL_IRQ_EN  Access: RW
+// Assert the DMA IRQ when this channel's INTR flag is set
+#define DMA_CH1_CTRL_IRQ_EN_LSB  6
+#define DMA_CH1_CTRL_IRQ_EN_BITS 1
+#define DMA_CH1_CTRL_IRQ_EN_MASK 0x40
+// Field: CH1_CTRL_READ_ZERO  Access: RW
+// If 1, skip the read, and write zero. READ_ADDR is ignored.
+#define DMA_CH1_CTRL_READ_ZERO_LSB  7
+#define DMA_CH1_CTRL_READ_ZERO_BITS 1
+#define DMA_CH1_CTRL_READ_ZERO_MASK 0x80
+// Field: CH1_CTRL_BUSY  Access: ROV
+// Channel is enabled and has transfers remaining
+#define DMA_CH1_CTRL_BUSY_LSB  8
+#define DMA_CH1_CTRL_BUSY_BITS 1
+#define DMA_CH1_CTRL_BUSY_MASK 0x100
+// Field: CH1_CTRL_ERR  Access: W1C
+// A bus error, or an address below SDRAM (e.g. TCM), stopped this channel.
+// COUNT has been cleared.
+#define DMA_CH1_CTRL_ERR_LSB  9
+#define DMA_CH1_CTRL_ERR_BITS 1
+#define DMA_CH1_CTRL_ERR_MASK 0x200
+
+/*******************************************************************************
+*                                CH1_PACE_ADDR                                 *
+*******************************************************************************/
+
+// Channel 1 pacing status address, e.g. a peripheral FIFO status register
+
+// Field: CH1_PACE_ADDR  Access: RW
+#define DMA_CH1_PACE_ADDR_LSB  0
+#define DMA_CH1_PACE_ADDR_BITS 32
+#define DMA_CH1_PACE_ADDR_MASK 0xffffffff
+
+/*******************************************************************************
+*                                CH1_PACE_MASK                                 *
+*******************************************************************************/
+
+// Channel 1 pacing status mask
+
+// Field: CH1_PACE_MASK  Access: RW
+#define DMA_CH1_PACE_MASK_LSB  0
+#define DMA_CH1_PACE_MASK_BITS 32
+#define DMA_CH1_PACE_MASK_MASK 0xffffffff
+
+/*******************************************************************************
+*                                CH1_PACE_MATCH                                *
+*******************************************************************************/
+
+// Channel 1 pacing status match value
+
+// Field: CH1_PACE_MATCH  Access: RW
+#define DMA_CH1_PACE_MATCH_LSB  0
+#define DMA_CH1_PACE_MATCH_BITS 32
+#define DMA_CH1_PACE_MATCH_MASK 0xffffffff
+
+/*******************************************************************************
+*                                     INTR                                     *
+*******************************************************************************/
+
+// Channel completion flags. Set when a channel's COUNT reaches 0. Write 1 to clear.
+
+// Field: INTR  Access: W1C
+#define DMA_INTR_LSB  0
+#define DMA_INTR_BITS 2
+#define DMA_INTR_MASK 0x3
+
+#endif // _DMA_REGS_H_
@@ -3,6 +3,12 @@
 
 #include "timer.h"
 
+static inline uint32_t get_core_num() {
+	uint32_t id;
+	asm volatile ("csrr %0, mhartid" : "=r" (id));
+	return id;
+}
+
 static inline void set_softirq(int i) {
 	mm_timer->softirq_set = 1u << i;
 }
@@ -0,0 +1,155 @@
+#ifndef _MULTICORE_QUEUE_H_
+#define _MULTICORE_QUEUE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "platform_defs.h"
+#include "multicore.h"
+
+// Lock-free bounded queue of 32-bit words (e.g. pointers), for passing work
+// between the cores. Any number of producers and consumers on either core,
+// including IRQ handlers, may use the same queue. A mailbox is just a queue
+// with a single slot.
+//
+// Queues must live in SDRAM, not TCM, as each core's TCM is private. SDRAM
+// accesses from both cores go through the shared system cache, so no cache
+// maintenance is needed, and the A extension's LR/SC are checked by the
+// cache's exclusive monitor.
+//
+// The blocking calls sleep on WFI until the queue changes. Every successful
+// push or pop rings the other core's doorbell (its soft IRQ). The soft IRQ is
+// only unmasked during the WFI, with IRQs globally disabled, so no
+// isr_machine_softirq handler is needed.
+//
+// Usage:
+//
+//   static queue_slot_t work_slots[16];
+//   static queue_t work;
+//
+//   queue_init(&work, work_slots, 16); // before launch_core1()
+//   queue_push_blocking(&work, (uint32_t)job);           // core 0
+//   job_t *job = (job_t*)queue_pop_blocking(&work);      // core 1
+
+#define QUEUE_ALIGN (CACHE_LINE_SIZE_WORDS * 4)
+
+// One 8-byte exclusive reservation granule per slot. seq tells producers and
+// consumers whose turn it is to use the slot.
+typedef struct queue_slot {
+	uint32_t seq;
+	uint32_t data;
+} queue_slot_t;
+
+// Producer and consumer indices are in separate cache lines
+typedef struct queue {
+	uint32_t tail __attribute__((aligned(QUEUE_ALIGN)));
+	uint32_t head __attribute__((aligned(QUEUE_ALIGN)));
+	queue_slot_t *slots __attribute__((aligned(QUEUE_ALIGN)));
+	uint32_t mask;
+} queue_t;
+
+// n_slots must be a power of two. Call before any other core uses the queue.
+static inline void queue_init(queue_t *q, queue_slot_t *slots, uint32_t n_slots) {
+	for (uint32_t i = 0; i < n_slots; ++i)
+		slots[i].seq = i;
+	q->slots = slots;
+	q->mask = n_slots - 1;
+	q->head = 0;
+	q->tail = 0;
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void queue_doorbell() {
+	set_softirq(get_core_num() ^ 1);
+}
+
+static inline bool queue_try_push(queue_t *q, uint32_t data) {
+	uint32_t pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+	queue_slot_t *slot;
+	while (true) {
+		slot = &q->slots[pos & q->mask];
+		int32_t diff = (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+		if (diff == 0) {
+			if (__atomic_compare_exchange_n(&q->tail, &pos, pos + 1, true,
+				__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		} else if (diff < 0) {
+			// Slot not yet freed by the consumer a lap behind
+			return false;
+		} else {
+			pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+		}
+	}
+	slot->data = data;
+	__atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+	queue_doorbell();
+	return true;
+}
+
+static inline bool queue_try_pop(queue_t *q, uint32_t *data) {
+	uint32_t pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+	queue_slot_t *slot;
+	while (true) {
+		slot = &q->slots[pos & q->mask];
+		int32_t diff = (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - (pos + 1));
+		if (diff == 0) {
+			if (__atomic_compare_exchange_n(&q->head, &pos, pos + 1, true,
+				__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		} else if (diff < 0) {
+			// Slot not yet filled
+			return false;
+		} else {
+			pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+		}
+	}
+	*data = slot->data;
+	__atomic_store_n(&slot->seq, pos + q->mask + 1, __ATOMIC_RELEASE);
+	queue_doorbell();
+	return true;
+}
+
+// Approximate, as the other core may be pushing or popping
+static inline uint32_t queue_level(const queue_t *q) {
+	return __atomic_load_n(&q->tail, __ATOMIC_RELAXED) - __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+}
+
+// Sleep until this core's doorbell rings, or some other enabled IRQ is
+// pending, unless ready() is already true. The doorbell is cleared *before*
+// checking, so a ring between the check and the WFI can't be lost. Pending
+// IRQs are taken on return.
+static inline void queue_wait(const queue_t *q, bool (*ready)(const queue_t *q)) {
+	uint32_t core = get_core_num();
+	uint32_t mstatus, mie;
+	asm volatile ("csrrci %0, mstatus, 0x8" : "=r" (mstatus) : : "memory");
+	asm volatile ("csrrs %0, mie, %1" : "=r" (mie) : "r" (1u << 3));
+	clr_softirq(core);
+	if (!ready(q))
+		__wfi();
+	if (!(mie & (1u << 3)))
+		asm volatile ("csrc mie, %0" : : "r" (1u << 3));
+	asm volatile ("csrs mstatus, %0" : : "r" (mstatus & 0x8) : "memory");
+}
+
+static inline bool queue_not_full(const queue_t *q) {
+	return queue_level(q) <= q->mask;
+}
+
+static inline bool queue_not_empty(const queue_t *q) {
+	return queue_level(q) != 0;
+}
+
+static inline void queue_push_blocking(queue_t *q, uint32_t data) {
+	while (!queue_try_push(q, data))
+		queue_wait(q, queue_not_full);
+}
+
+static inline uint32_t queue_pop_blocking(queue_t *q) {
+	uint32_t data;
+	while (!queue_try_pop(q, &data))
+		queue_wait(q, queue_not_empty);
+	return data;
+}
+
+#endif // _MULTICORE_QUEUE_H_
@@ -0,0 +1,84 @@
+#ifndef _PERF_H
+#define _PERF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "addressmap.h"
+#include "hw/perf_regs.h"
+
+#define PERF_N_COUNTERS 4
+
+typedef struct perf_hw {
+	io_rw_32 ctrl;
+	io_rw_32 sel[PERF_N_COUNTERS];
+	struct {
+		io_rw_32 l;
+		io_rw_32 h;
+	} ctr[PERF_N_COUNTERS];
+} perf_hw_t;
+
+#define mm_perf ((perf_hw_t*)PERF_BASE)
+
+// Each event is counted once per cycle in which it occurs. "Stall" events
+// count cycles. Shared cache hits are CACHE_ACCESS minus CACHE_FILL. Must
+// match the event list in soc.v.
+enum perf_event {
+	PERF_EVENT_NONE           = 0,
+	PERF_EVENT_CYCLES         = 1,
+	PERF_EVENT_CACHE_ACCESS   = 2,  // SDRAM transfers into the shared cache, all masters
+	PERF_EVENT_CACHE_FILL     = 3,  // Shared cache line fills from SDRAM (misses)
+	PERF_EVENT_CACHE_WB       = 4,  // Shared cache line writebacks to SDRAM
+	PERF_EVENT_CACHE_ACCESS0  = 5,  // SDRAM transfers into the shared cache from core 0
+	PERF_EVENT_CACHE_ACCESS1  = 6,  // SDRAM transfers into the shared cache from core 1
+	PERF_EVENT_CACHE_STALL0   = 7,  // Cycles core 0 waits on the shared cache, any reason
+	PERF_EVENT_CACHE_STALL1   = 8,  // Cycles core 1 waits on the shared cache, any reason
+	PERF_EVENT_ARB_STALL0     = 9,  // Cycles core 0 waits on the arbiter, for core 1 or DMA
+	PERF_EVENT_ARB_STALL1     = 10, // Cycles core 1 waits on the arbiter, for core 0 or DMA
+	PERF_EVENT_SDRAM_BUSY     = 11, // Cycles the SDRAM controller stalls the bus
+	PERF_EVENT_SDRAM_ACTIVATE = 12, // SDRAM row activations
+	PERF_EVENT_SDRAM_REFRESH  = 13, // SDRAM refresh commands
+	PERF_EVENT_ICACHE0_HIT    = 14,
+	PERF_EVENT_ICACHE0_MISS   = 15,
+	PERF_EVENT_ICACHE1_HIT    = 16,
+	PERF_EVENT_ICACHE1_MISS   = 17,
+	PERF_EVENT_CACHE_ACCESS2  = 18  // SDRAM transfers into the shared cache from the DMA
+};
+
+static inline void perf_counter_enable(int ctr, bool en) {
+	if (en)
+		mm_perf->ctrl |= 1u << ctr;
+	else
+		mm_perf->ctrl &= ~(1u << ctr);
+}
+
+// Start/stop several counters at once, so they cover exactly the same cycles
+static inline void perf_counters_enable_mask(uint32_t mask) {
+	mm_perf->ctrl = mask & PERF_CTRL_MASK;
+}
+
+static inline void perf_counter_set(int ctr, uint64_t count) {
+	mm_perf->ctr[ctr].l = 0;
+	mm_perf->ctr[ctr].h = count >> 32;
+	mm_perf->ctr[ctr].l = count & 0xffffffffu;
+}
+
+static inline uint64_t perf_counter_get(int ctr) {
+	uint32_t h0, l, h1;
+	do {
+		h0 = mm_perf->ctr[ctr].h;
+		l  = mm_perf->ctr[ctr].l;
+		h1 = mm_perf->ctr[ctr].h;
+	} while (h0 != h1);
+	return (uint64_t)h0 << 32 | l;
+}
+
+// Stop the counter, point it at a new event, and zero it. Enable it
+// afterward to start counting.
+static inline void perf_counter_config(int ctr, enum perf_event event) {
+	perf_counter_enable(ctr, false);
+	mm_perf->sel[ctr] = event;
+	perf_counter_set(ctr, 0);
+}
+
+#endif
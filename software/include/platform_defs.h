@@ -18,6 +18,9 @@
 #define CACHE_SIZE_WORDS 1024
 #define CACHE_LINE_SIZE_WORDS 4
 
-#define __tcm(obj) __attribute__((section(".tcm." #obj) obj
+#define __tcm(obj) __attribute__((section(".tcm." #obj))) obj
+
+// Execute in place from flash. See memmap_sdram.ld.
+#define __xip(obj) __attribute__((section(".xip." #obj))) obj
 
 #endif
@@ -2,7 +2,7 @@
 #define _SDRAM_H
 
 #include "platform_defs.h"
-#include "hw/sdram_ctrl_regs.h"
+#include "hw/sdramctrl_regs.h"
 #include "delay.h"
 
 #include <stdint.h>
@@ -27,10 +27,10 @@ typedef struct sdram_ctrl_hw {
 
 static inline void sdram_init_seq() {
 	// Power up (start transmitting clock) but don't enable automatic operations
-	mm_sdram_ctrl->csr = SDRAM_CSR_PU_MASK;
+	mm_sdram_ctrl->csr = SDRAMCTRL_CSR_PU_MASK;
 	delay_us(10);
 	// PrechargeAll, 3 refreshes
-	mm_sdram_ctrl->cmd_direct = SDRAM_CMD_PRECHARGE | 1u << (SDRAM_CMD_DIRECT_ADDR_LSB + 10);
+	mm_sdram_ctrl->cmd_direct = SDRAM_CMD_PRECHARGE | 1u << (SDRAMCTRL_CMD_DIRECT_ADDR_LSB + 10);
 	delay_us(10);
 	for (int i = 0; i < 3; ++i)	{
 		mm_sdram_ctrl->cmd_direct = SDRAM_CMD_REFRESH;
@@ -45,27 +45,38 @@ static inline void sdram_init_seq() {
 		(0x2u << 4) | // CAS latency 2
 		(0x0u << 9);  // Write bursts same length as reads
 
-	mm_sdram_ctrl->cmd_direct = SDRAM_CMD_LOAD_MODE_REG | modereg << SDRAM_CMD_DIRECT_ADDR_LSB;
+	mm_sdram_ctrl->cmd_direct = SDRAM_CMD_LOAD_MODE_REG | modereg << SDRAMCTRL_CMD_DIRECT_ADDR_LSB;
 	delay_us(10);
 
 	mm_sdram_ctrl->time =
-		(1u << SDRAM_TIME_CAS_LSB) | // tCAS - 1    2 clk
-		(0u << SDRAM_TIME_WR_LSB)  | // tWR - 1     14 ns 1 clk
-		(1u << SDRAM_TIME_RAS_LSB) | // tRAS - 1    42 ns 2 clk
-		(0u << SDRAM_TIME_RRD_LSB) | // tRRD - 1    14 ns 1 clk
-		(0u << SDRAM_TIME_RP_LSB)  | // tRP - 1     21 ns 1 clk
-		(0u << SDRAM_TIME_RCD_LSB) | // tRCD - 1    21 ns 1 clk
-		(2u << SDRAM_TIME_RC_LSB);   // tRC - 1     63 ns 3 clk (also tRFC)
+		(1u << SDRAMCTRL_TIME_CAS_LSB) | // tCAS - 1    2 clk
+		(0u << SDRAMCTRL_TIME_WR_LSB)  | // tWR - 1     14 ns 1 clk
+		(1u << SDRAMCTRL_TIME_RAS_LSB) | // tRAS - 1    42 ns 2 clk
+		(0u << SDRAMCTRL_TIME_RRD_LSB) | // tRRD - 1    14 ns 1 clk
+		(0u << SDRAMCTRL_TIME_RP_LSB)  | // tRP - 1     21 ns 1 clk
+		(0u << SDRAMCTRL_TIME_RCD_LSB) | // tRCD - 1    21 ns 1 clk
+		(2u << SDRAMCTRL_TIME_RC_LSB);   // tRC - 1     63 ns 3 clk (also tRFC)
 
 	mm_sdram_ctrl->refresh = 312; // 7.8 us
 
 	// Now that we don't need the direct cmd interface, and safe timings are
 	// configured, we can enable the controller
-	mm_sdram_ctrl->csr |= SDRAM_CSR_EN_MASK;
+	mm_sdram_ctrl->csr |= SDRAMCTRL_CSR_EN_MASK;
+}
+
+// Open-page: rows stay open until an access to another row in the same bank,
+// or a refresh. Close-page: every access precharges its bank. Safe to change
+// at any time. Only the SDRAM_CTRL="OPEN_PAGE" controller implements this;
+// libfpga's controller ignores the bit, and is always close-page.
+static inline void sdram_set_open_page(bool open_page) {
+	if (open_page)
+		mm_sdram_ctrl->csr |= SDRAMCTRL_CSR_OPEN_PAGE_MASK;
+	else
+		mm_sdram_ctrl->csr &= ~SDRAMCTRL_CSR_OPEN_PAGE_MASK;
 }
 
 static inline bool sdram_is_enabled() {
-	return !!(mm_sdram_ctrl->csr & SDRAM_CSR_EN_MASK);
+	return !!(mm_sdram_ctrl->csr & SDRAMCTRL_CSR_EN_MASK);
 }
 
 #endif
@@ -6,6 +6,7 @@
 #include <stdbool.h>
 
 #include "addressmap.h"
+#include "platform_defs.h"
 #include "hw/spi_regs.h"
 
 typedef struct spi_hw {
@@ -37,16 +38,34 @@ static inline void spi_init(bool cpol, bool cpha)
 	mm_spi->fstat = SPI_FSTAT_TXOVER_MASK | SPI_FSTAT_RXOVER_MASK | SPI_FSTAT_RXUNDER_MASK;
 }
 
+// Must match FIFO_DEPTH of spi0_u in soc.v. Bytes are only pushed while there
+// are fewer than this many in flight (TX FIFO + shifter + RX FIFO), so the RX
+// FIFO can never overflow.
+#define SPI_FIFO_DEPTH 8
+
+static inline size_t spi_tx_level(uint32_t fstat) {
+	return (fstat & SPI_FSTAT_TXLEVEL_MASK) >> SPI_FSTAT_TXLEVEL_LSB;
+}
+
+static inline size_t spi_rx_level(uint32_t fstat) {
+	return (fstat & SPI_FSTAT_RXLEVEL_MASK) >> SPI_FSTAT_RXLEVEL_LSB;
+}
+
+// Write-only transfer. Any RX data is discarded by the next spi_flush().
 static inline void spi_write(const uint8_t *data, size_t len)
 {
-	for(; len > 0; --len)
-	{
-		while (mm_spi->fstat & SPI_FSTAT_TXFULL_MASK)
-			;
-		mm_spi->tx = *data++;
+	while (len) {
+		size_t space = SPI_FIFO_DEPTH - spi_tx_level(mm_spi->fstat);
+		if (space > len)
+			space = len;
+		len -= space;
+		for (; space > 0; --space)
+			mm_spi->tx = *data++;
 	}
 }
 
+// Full-duplex transfer. FSTAT is read once per batch, then as many bytes are
+// moved in each direction as the FIFO levels allow.
 static inline void spi_write_read(const uint8_t *tx, uint8_t *rx, size_t len)
 {
 	spi_flush();
@@ -54,19 +73,88 @@ static inline void spi_write_read(const uint8_t *tx, uint8_t *rx, size_t len)
 	size_t tx_remaining = len;
 	size_t rx_remaining = len;
 
-	while (tx_remaining || rx_remaining) {
-		uint32_t status = mm_spi->fstat;
-		if (tx_remaining && !(status & SPI_FSTAT_TXFULL_MASK)) {
-			--tx_remaining;
+	while (rx_remaining) {
+		size_t rx_level = spi_rx_level(mm_spi->fstat);
+		rx_remaining -= rx_level;
+		for (; rx_level > 0; --rx_level)
+			*rx++ = mm_spi->rx;
+		// Bytes in flight: rx_remaining - tx_remaining
+		for (; tx_remaining && rx_remaining - tx_remaining < SPI_FIFO_DEPTH; --tx_remaining)
 			mm_spi->tx = *tx++;
-		}
-		if (!(status & SPI_FSTAT_RXEMPTY_MASK)) {
-			--rx_remaining;
+	}
+}
+
+// Receive-only transfers, sending `fill` for every byte, so no TX buffer is
+// needed. spi_read() fills the cache-line-aligned middle of the buffer with
+// spi_read_lines(), which gathers each whole line in registers (four bytes
+// per word, read with an unrolled loop) and then stores it with back-to-back
+// word writes. Each destination line then costs the system cache four
+// consecutive word writes, instead of sixteen byte writes interleaved with
+// FIFO polling.
+
+#define SPI_LINE_WORDS CACHE_LINE_SIZE_WORDS
+
+static inline void spi_read_bytes(uint8_t *rx, size_t len, uint8_t fill)
+{
+	size_t tx_remaining = len;
+	while (len) {
+		size_t rx_level = spi_rx_level(mm_spi->fstat);
+		len -= rx_level;
+		for (; rx_level > 0; --rx_level)
 			*rx++ = mm_spi->rx;
+		for (; tx_remaining && len - tx_remaining < SPI_FIFO_DEPTH; --tx_remaining)
+			mm_spi->tx = fill;
+	}
+}
+
+// rx must be aligned to a cache line
+static inline void spi_read_lines(uint32_t *rx, size_t n_lines, uint8_t fill)
+{
+	size_t n_bytes = n_lines * SPI_LINE_WORDS * 4;
+	size_t tx_count = 0;
+	size_t rx_count = 0;
+	for (; n_lines > 0; --n_lines) {
+		uint32_t line[SPI_LINE_WORDS];
+		for (int i = 0; i < SPI_LINE_WORDS; ++i) {
+			// Keep the FIFOs full while waiting for the next word
+			while (true) {
+				for (; tx_count < n_bytes && tx_count - rx_count < SPI_FIFO_DEPTH; ++tx_count)
+					mm_spi->tx = fill;
+				if (spi_rx_level(mm_spi->fstat) >= 4)
+					break;
+			}
+			// Little-endian: first byte ends up in the LSBs
+			uint32_t w = mm_spi->rx;
+			w |= (uint32_t)mm_spi->rx << 8;
+			w |= (uint32_t)mm_spi->rx << 16;
+			w |= (uint32_t)mm_spi->rx << 24;
+			line[i] = w;
+			rx_count += 4;
 		}
+		for (int i = 0; i < SPI_LINE_WORDS; ++i)
+			*rx++ = line[i];
 	}
 }
 
+static inline void spi_read(uint8_t *rx, size_t len, uint8_t fill)
+{
+	spi_flush();
+
+	size_t head = -(uintptr_t)rx & (SPI_LINE_WORDS * 4 - 1);
+	if (head > len)
+		head = len;
+	spi_read_bytes(rx, head, fill);
+	rx += head;
+	len -= head;
+
+	size_t n_lines = len / (SPI_LINE_WORDS * 4);
+	spi_read_lines((uint32_t*)rx, n_lines, fill);
+	rx += n_lines * SPI_LINE_WORDS * 4;
+	len -= n_lines * SPI_LINE_WORDS * 4;
+
+	spi_read_bytes(rx, len, fill);
+}
+
 static inline void spi_wait_done()
 {
 	while (mm_spi->csr & SPI_CSR_BUSY_MASK)
@@ -1,7 +1,11 @@
 #ifndef _TIMER_H
 #define _TIMER_H
 
+#include <stdint.h>
+#include <stdbool.h>
+
 #include "addressmap.h"
+#include "platform_defs.h"
 #include "hw/timer_regs.h"
 
 typedef struct timer_hw {
@@ -17,13 +21,13 @@ typedef struct timer_hw {
 
 #define mm_timer ((timer_hw_t*)TIMER_BASE)
 
-void timer_set_time(uint64_t t) {
+static inline void timer_set_time(uint64_t t) {
 	mm_timer->time = 0;
 	mm_timer->timeh = t >> 32;
 	mm_timer->time = t & 0xffffffffu;
 }
 
-uint64_t timer_get_time(void) {
+static inline uint64_t timer_get_time(void) {
 	uint32_t h0, l, h1;
 	do {
 		h0 = mm_timer->timeh;
@@ -33,16 +37,22 @@ uint64_t timer_get_time(void) {
 	return (uint64_t)h0 << 32 | l;
 }
 
-void timer_set_timecmp(int core, uint64_t cmp) {
+// The timer IRQ for each core is asserted while time >= that core's timecmp
+static inline void timer_set_timecmp(int core, uint64_t cmp) {
 	io_rw_32 *l = core == 0 ? &mm_timer->timecmp0 : &mm_timer->timecmp1;
 	io_rw_32 *h = core == 0 ? &mm_timer->timecmp0h : &mm_timer->timecmp1h;
 
 	// No lower than requested
-	l = 0xffffffffu;
+	*l = 0xffffffffu;
 	// No lower than requested
-	h = cmp >> 32;
+	*h = cmp >> 32;
 	// Equal to requested
-	l = cmp & 0xffffffffu;
+	*l = cmp & 0xffffffffu;
+}
+
+// Timer counts at the system clock frequency
+static inline uint64_t timer_us_to_ticks(uint64_t us) {
+	return us * CLK_SYS_MHZ;
 }
 
 #endif
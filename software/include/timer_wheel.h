@@ -0,0 +1,83 @@
+#ifndef _TIMER_WHEEL_H_
+#define _TIMER_WHEEL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "timer.h"
+
+// Per-core software timeouts, driven by that core's timer comparator. Add
+// ../../src/timer_wheel.c to your SRCS.
+//
+// Each core has a hashed timing wheel of TIMER_WHEEL_SLOTS slots, each
+// covering 1 << TIMER_WHEEL_SLOT_SHIFT timer ticks. A timeout is placed in
+// the slot for its deadline, so adding and cancelling are O(1), regardless of
+// how many timeouts are pending. The timer is tickless: the comparator is
+// programmed for the earliest pending deadline, rather than interrupting every
+// slot. Timeouts more than one revolution of the wheel away share slots with
+// nearer ones, and cost one extra interrupt per revolution.
+//
+// Setup, on each core which uses timeouts:
+//
+//   timer_wheel_init();
+//
+// and call timer_wheel_irq() from your timer IRQ handler, e.g.
+//
+//   void __attribute__((interrupt)) isr_machine_timer() {
+//       timer_wheel_irq();
+//   }
+//
+// Timeouts belong to the core which added them, and their callbacks run in
+// that core's timer IRQ handler.
+
+#ifndef TIMER_WHEEL_SLOTS
+#define TIMER_WHEEL_SLOTS 256
+#endif
+
+// Default is 4096 ticks, ~100 us at 40 MHz, for ~26 ms per revolution
+#ifndef TIMER_WHEEL_SLOT_SHIFT
+#define TIMER_WHEEL_SLOT_SHIFT 12
+#endif
+
+struct timeout;
+typedef void (*timeout_callback_t)(struct timeout *t);
+
+// Zero-initialise before first use. Must stay valid while pending.
+typedef struct timeout {
+	struct timeout *next;
+	struct timeout **pprev;
+	uint64_t deadline;
+	timeout_callback_t callback;
+	void *arg;
+} timeout_t;
+
+// Set up the wheel for the calling core, and enable its timer IRQ
+void timer_wheel_init(void);
+
+// Run callbacks for expired timeouts, and reprogram the comparator
+void timer_wheel_irq(void);
+
+// Call callback(t) once the timer reaches deadline (in timer ticks). t must
+// not already be pending.
+void timeout_add(timeout_t *t, uint64_t deadline, timeout_callback_t callback);
+
+// Returns true if t was still pending
+bool timeout_cancel(timeout_t *t);
+
+static inline bool timeout_pending(const timeout_t *t) {
+	return t->pprev != NULL;
+}
+
+// Sleep (WFI) until the timer reaches time. Other IRQs are still serviced.
+void sleep_until(uint64_t time);
+
+static inline void sleep_us(uint32_t us) {
+	sleep_until(timer_get_time() + timer_us_to_ticks(us));
+}
+
+static inline void sleep_ms(uint32_t ms) {
+	sleep_until(timer_get_time() + timer_us_to_ticks((uint64_t)ms * 1000));
+}
+
+#endif // _TIMER_WHEEL_H_
@@ -0,0 +1,75 @@
+#ifndef _UART_BUFFERED_H_
+#define _UART_BUFFERED_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "uart.h"
+
+// Interrupt-driven UART driver. Add ../../src/uart_buffered.c to your SRCS.
+//
+// Each core has its own TX ring, so both cores can write at once without
+// locking: each ring has exactly one producer (its core) and one consumer
+// (the UART IRQ handler). The handler prefers to finish a line from one core
+// before switching to the other, so lines from the two cores don't get mixed
+// together unless a line is longer than the ring. There is a single RX ring,
+// which must only be read from one core.
+//
+// Writes return as soon as the data is in the ring. A full TX ring makes the
+// writer wait for the handler to make space, so don't write from an ISR, or
+// with IRQs disabled on the core which services the UART.
+//
+// Setup, on the core which will service the UART IRQ:
+//
+//   uart_clkdiv_baud(CLK_SYS_MHZ, UART_BAUD);
+//   uart_init();
+//   uart_buffered_init();
+//
+// and call uart_buffered_irq() from your external IRQ handler, e.g.
+//
+//   void __attribute__((interrupt)) isr_external_irq() {
+//       uart_buffered_irq();
+//   }
+
+#ifndef UART_TX_RING_SIZE
+#define UART_TX_RING_SIZE 1024
+#endif
+
+#ifndef UART_RX_RING_SIZE
+#define UART_RX_RING_SIZE 256
+#endif
+
+#define UART_IRQ 0
+
+// Enable UART interrupts on the calling core
+void uart_buffered_init(void);
+
+// Move data between the rings and the UART FIFOs
+void uart_buffered_irq(void);
+
+// Queue up to len bytes, without waiting. Returns the number queued.
+size_t uart_buffered_write_nonblocking(const uint8_t *data, size_t len);
+
+// Queue all len bytes, waiting for ring space if necessary
+void uart_buffered_write(const uint8_t *data, size_t len);
+
+void uart_buffered_putc(char c);
+
+// As uart_puts(): \n is sent as \r\n
+void uart_buffered_puts(const char *s);
+
+void uart_buffered_printf(const char *fmt, ...);
+
+// Returns -1 if no data is available
+int uart_buffered_getc(void);
+
+size_t uart_buffered_rx_level(void);
+
+// Number of received bytes dropped because the RX ring was full
+uint32_t uart_buffered_rx_dropped(void);
+
+// Wait until everything queued by either core has been sent
+void uart_buffered_flush(void);
+
+#endif // _UART_BUFFERED_H_
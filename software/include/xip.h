@@ -0,0 +1,47 @@
+#ifndef _XIP_H_
+#define _XIP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "addressmap.h"
+#include "hw/spi_03h_xip_regs.h"
+
+// The whole of flash can be read through the XIP window, at XIP_BASE plus the
+// flash address. Reads go through the system cache, so XIP code and data run
+// at SDRAM speed once cached. The window is read-only, and writes to it get a
+// bus error. Flash is programmed with spi.h (or direct mode below), after
+// which any cached copies of the programmed range must be dropped with
+// cache_invalidate_range().
+//
+// The XIP controller shares the flash pins with the SPI peripheral. An XIP
+// access made whilst the SPI has the flash selected waits until the SPI
+// deselects it. Code that selects the flash through the SPI must not run from,
+// or read, the XIP window itself, as it would wait forever.
+
+typedef struct xip_hw {
+	io_rw_32 csr;
+	io_wo_32 txdata;
+	io_ro_32 rxdata;
+} xip_hw_t;
+
+#define mm_xip ((xip_hw_t*)XIP_CTRL_BASE)
+
+static inline const volatile void *xip_ptr(uint32_t flash_addr) {
+	return (const volatile void*)(uintptr_t)(XIP_BASE + (flash_addr & (XIP_SIZE - 1)));
+}
+
+// Direct mode holds chip select asserted until disabled. Must not be used
+// while executing from the XIP window.
+static inline void xip_direct_enable(bool en) {
+	mm_xip->csr = en ? XIP_CSR_DIRECT_MASK : 0;
+}
+
+static inline uint8_t xip_direct_xfer(uint8_t tx) {
+	mm_xip->txdata = tx;
+	while (mm_xip->csr & XIP_CSR_BUSY_MASK)
+		;
+	return mm_xip->rxdata;
+}
+
+#endif // _XIP_H_
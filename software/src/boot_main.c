@@ -2,17 +2,207 @@
 #include "uart.h"
 #include "sdram.h"
 #include "spi.h"
+#include "dma.h"
+#include "flash_image.h"
 
 #define SPI_LOAD_ADDR 0x100000u
 
+// The bootloader always uses plain 03h reads. spi_mini has one data line in
+// each direction, so the dual and quad read commands are not usable, and Fast
+// Read (0Bh) only helps above the 03h SCK limit (around 50 MHz on common
+// parts). SCK here is CLK_SYS_MHZ / 2, so 0Bh would just add a dummy byte.
+#define SPI_CMD_READ 0x03u
+
 const char *splash_text = "\n"
 "  ___ _        _    _                 ___       ___ \n"
 " / __| |_  _ _(_)__| |_ _ __  __ _ __/ __| ___ / __|\n"
 "| (__| ' \\| '_| (_-<  _| '  \\/ _` (_-<__ \\/ _ \\ (__ \n"
 " \\___|_||_|_| |_/__/\\__|_|_|_\\__,_/__/___/\\___/\\___|\n";
 
-uint8_t *sdram = (uint8_t*)SDRAM_BASE;
-void (*sdram_entry)(void) = (void(*)(void))(SDRAM_BASE + 0x40u);
+// ----------------------------------------------------------------------------
+// Streaming reads from flash
+
+// Bytes are pushed to the SPI TX FIFO whenever there is room, so the SPI
+// keeps shifting while the bytes already received are being decoded. The
+// stream may run past the end of the image: anything left in flight is
+// discarded when chip select is released.
+
+static uint32_t stream_rx_avail;
+static uint32_t stream_in_flight;
+// Count of bytes returned by stream_get(), for checking segment sizes
+static uint32_t stream_count;
+
+static void stream_start() {
+	spi_flush();
+	stream_rx_avail = 0;
+	stream_in_flight = 0;
+	stream_count = 0;
+}
+
+static uint8_t stream_get() {
+	while (!stream_rx_avail) {
+		for (; stream_in_flight < SPI_FIFO_DEPTH; ++stream_in_flight)
+			mm_spi->tx = 0;
+		stream_rx_avail = spi_rx_level(mm_spi->fstat);
+	}
+	--stream_rx_avail;
+	--stream_in_flight;
+	++stream_count;
+	return mm_spi->rx;
+}
+
+static uint32_t stream_get_u32() {
+	uint32_t x = 0;
+	for (int i = 0; i < 32; i += 8)
+		x |= (uint32_t)stream_get() << i;
+	return x;
+}
+
+// ----------------------------------------------------------------------------
+// Segment output, with CRC-32
+
+// Half-byte table, to keep the bootloader small
+static const uint32_t crc_table[16] = {
+	0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+	0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+	0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+	0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+};
+
+static uint8_t *out_base;
+static uint8_t *out_ptr;
+static uint8_t *out_end;
+static uint32_t out_crc;
+
+static void out_byte(uint8_t x) {
+	*out_ptr++ = x;
+	out_crc ^= x;
+	out_crc = (out_crc >> 4) ^ crc_table[out_crc & 0xf];
+	out_crc = (out_crc >> 4) ^ crc_table[out_crc & 0xf];
+}
+
+static uint32_t lz4_len(uint32_t len) {
+	if (len == 15) {
+		uint8_t x;
+		do {
+			x = stream_get();
+			len += x;
+		} while (x == 255);
+	}
+	return len;
+}
+
+// Decode one LZ4 block from the stream, filling the output range exactly.
+static bool lz4_decode() {
+	while (true) {
+		uint8_t token = stream_get();
+		uint32_t len = lz4_len(token >> 4);
+		if (len > (uint32_t)(out_end - out_ptr))
+			return false;
+		for (; len > 0; --len)
+			out_byte(stream_get());
+		// The last sequence has literals only
+		if (out_ptr == out_end)
+			return true;
+		uint32_t offset = stream_get();
+		offset |= (uint32_t)stream_get() << 8;
+		len = lz4_len(token & 0xf) + 4;
+		if (offset == 0 || offset > (uint32_t)(out_ptr - out_base) ||
+			len > (uint32_t)(out_end - out_ptr))
+			return false;
+		const uint8_t *src = out_ptr - offset;
+		for (; len > 0; --len)
+			out_byte(*src++);
+	}
+}
+
+// ----------------------------------------------------------------------------
+// Image loading
+
+static void (*load_legacy_image(void))(void) {
+	uint32_t len;
+	spi_read((uint8_t*)&len, 4, 0);
+	uart_puts("Size:  ");
+	uart_putint(len);
+	uart_puts("\n");
+	if (len > SDRAM_SIZE) {
+		uart_puts("Bad size\n");
+		return NULL;
+	}
+
+	// The DMA runs the image load at close to the SPI wire rate
+	if (!dma_spi_read((uint8_t*)SDRAM_BASE, len)) {
+		uart_puts("DMA error\n");
+		return NULL;
+	}
+	return (void(*)(void))(SDRAM_BASE + 0x40u);
+}
+
+static void (*load_image(void))(void) {
+	stream_start();
+	uint32_t version = stream_get_u32();
+	uint32_t entry = stream_get_u32();
+	uint32_t n_segments = stream_get_u32();
+	if (version != FLASH_IMAGE_VERSION) {
+		uart_puts("Bad version\n");
+		return NULL;
+	}
+
+	for (; n_segments > 0; --n_segments) {
+		flash_segment_header_t seg;
+		seg.load_addr = stream_get_u32();
+		seg.size = stream_get_u32();
+		seg.stored_size = stream_get_u32();
+		seg.type = stream_get_u32();
+		seg.crc = stream_get_u32();
+		uart_puts("Load:  ");
+		uart_putint(seg.load_addr);
+		uart_puts(" +");
+		uart_putint(seg.size);
+		uart_puts("\n");
+
+		// Headers aren't covered by the CRC, so check them before writing
+		// anything: only SDRAM may be loaded, as the bootloader is running
+		// from TCM.
+		uint32_t offs = seg.load_addr - SDRAM_BASE;
+		if (seg.load_addr < SDRAM_BASE || offs > SDRAM_SIZE || seg.size > SDRAM_SIZE - offs) {
+			uart_puts("Bad load address\n");
+			return NULL;
+		}
+		if ((seg.type == FLASH_SEG_ZERO && seg.stored_size != 0) ||
+			(seg.type == FLASH_SEG_RAW && seg.stored_size != seg.size)) {
+			uart_puts("Bad stored size\n");
+			return NULL;
+		}
+
+		out_base = (uint8_t*)seg.load_addr;
+		out_ptr = out_base;
+		out_end = out_base + seg.size;
+		out_crc = 0xffffffffu;
+		uint32_t stream_data_start = stream_count;
+		if (seg.type == FLASH_SEG_ZERO) {
+			while (out_ptr != out_end)
+				*out_ptr++ = 0;
+			continue;
+		} else if (seg.type == FLASH_SEG_RAW) {
+			while (out_ptr != out_end)
+				out_byte(stream_get());
+		} else if (seg.type == FLASH_SEG_LZ4) {
+			if (!lz4_decode() || stream_count - stream_data_start != seg.stored_size) {
+				uart_puts("Bad LZ4 data\n");
+				return NULL;
+			}
+		} else {
+			uart_puts("Bad segment type\n");
+			return NULL;
+		}
+		if (~out_crc != seg.crc) {
+			uart_puts("Bad CRC\n");
+			return NULL;
+		}
+	}
+	return (void(*)(void))entry;
+}
 
 void main() {
 	// Enable SDRAM immediately, before debugger attaches
@@ -26,38 +216,33 @@ void main() {
 	spi_init(false, false);
 	spi_clkdiv(2);
 	mm_spi->csr = mm_spi->csr & ~(SPI_CSR_CSAUTO_MASK | SPI_CSR_CS_MASK);
-	uint8_t buf[] = {
-		0x03,
+	uint8_t cmd[] = {
+		SPI_CMD_READ,
 		SPI_LOAD_ADDR >> 16 & 0xff,
 		SPI_LOAD_ADDR >> 8 & 0xff,
 		SPI_LOAD_ADDR & 0xff
 	};
-	spi_write(buf, 4);
+	spi_write(cmd, 4);
 
-	spi_write_read(buf, buf, 4);
+	uint32_t magic;
+	spi_read((uint8_t*)&magic, 4, 0);
 	uart_puts("Magic: ");
-	uart_putint(*(uint32_t*)buf);
+	uart_putint(magic);
 	uart_puts("\n");
-	if (buf[0] != 'C' || buf[1] != 'S' || buf[2] != 'o' || buf[3] != 'C') {
-		uart_puts("Bad magic\n");
-		return;
-	}
 
-	spi_write_read(buf, buf, 4);
-	uint32_t len = (uint32_t)buf[0] | (buf[1] << 8) | (buf[2] << 16) | (buf[3] << 24);
-	uart_puts("Size:  ");
-	uart_putint(len);
-	uart_puts("\n");
-	if (len > SDRAM_SIZE) {
-		uart_puts("Bad size\n");
-		return;
-	}
-
-	spi_write_read(sdram, sdram, len);
+	void (*entry)(void) = NULL;
+	if (magic == FLASH_IMAGE_MAGIC)
+		entry = load_image();
+	else if (magic == FLASH_IMAGE_MAGIC_LEGACY)
+		entry = load_legacy_image();
+	else
+		uart_puts("Bad magic\n");
 	mm_spi->csr |= SPI_CSR_CS_MASK;
+	if (!entry)
+		return;
 
 	uart_puts("Flash boot OK\n");
 
-	sdram_entry();
+	entry();
 
 }
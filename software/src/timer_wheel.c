@@ -0,0 +1,208 @@
+#include "timer_wheel.h"
+#include "multicore.h"
+
+#define N_CORES 2
+
+#if TIMER_WHEEL_SLOTS & (TIMER_WHEEL_SLOTS - 1) || TIMER_WHEEL_SLOTS < 32
+#error "TIMER_WHEEL_SLOTS must be a power of two, at least 32"
+#endif
+
+#define BITMAP_WORDS (TIMER_WHEEL_SLOTS / 32)
+
+// Each wheel is only touched by its own core, from thread context with IRQs
+// disabled, or from its timer IRQ.
+typedef struct {
+	timeout_t *slots[TIMER_WHEEL_SLOTS];
+	// A set bit means the slot *may* be occupied. Bits are cleared lazily,
+	// when an empty slot is visited, so cancelling doesn't have to.
+	uint32_t occupied[BITMAP_WORDS];
+	// Absolute slot number (time >> TIMER_WHEEL_SLOT_SHIFT) up to which
+	// expired timeouts have been run
+	uint64_t cursor;
+	// Current comparator value
+	uint64_t cmp;
+} wheel_t;
+
+static wheel_t wheels[N_CORES];
+
+static inline uint32_t irq_save() {
+	uint32_t mstatus;
+	asm volatile ("csrrci %0, mstatus, 0x8" : "=r" (mstatus) : : "memory");
+	return mstatus;
+}
+
+static inline void irq_restore(uint32_t mstatus) {
+	asm volatile ("csrs mstatus, %0" : : "r" (mstatus & 0x8) : "memory");
+}
+
+static inline void list_push(timeout_t **head, timeout_t *t) {
+	t->next = *head;
+	if (t->next)
+		t->next->pprev = &t->next;
+	t->pprev = head;
+	*head = t;
+}
+
+static inline void list_remove(timeout_t *t) {
+	*t->pprev = t->next;
+	if (t->next)
+		t->next->pprev = t->pprev;
+	t->next = NULL;
+	t->pprev = NULL;
+}
+
+static inline void set_cmp(wheel_t *w, uint64_t cmp) {
+	w->cmp = cmp;
+	timer_set_timecmp(w - wheels, cmp);
+}
+
+// Index of the first possibly-occupied slot at or after slot, wrapping
+// around, or -1 if none
+static int next_occupied(const wheel_t *w, uint32_t slot) {
+	for (int i = 0; i <= BITMAP_WORDS; ++i) {
+		uint32_t word = (slot / 32 + i) % BITMAP_WORDS;
+		uint32_t bits = w->occupied[word];
+		if (i == 0)
+			bits &= ~0u << (slot % 32);
+		if (bits)
+			return word * 32 + __builtin_ctz(bits);
+	}
+	return -1;
+}
+
+// Program the comparator for the earliest deadline. Slots are visited in
+// time order from the cursor, and the first slot containing a timeout for
+// this revolution holds the earliest deadline.
+static void reprogram(wheel_t *w) {
+	uint32_t dist = 0;
+	bool any = false;
+	while (dist < TIMER_WHEEL_SLOTS) {
+		int idx = next_occupied(w, (w->cursor + dist) % TIMER_WHEEL_SLOTS);
+		if (idx < 0)
+			break;
+		uint32_t d = (idx - (uint32_t)w->cursor) % TIMER_WHEEL_SLOTS;
+		if (d < dist)
+			break;
+		if (!w->slots[idx]) {
+			w->occupied[idx / 32] &= ~(1u << (idx % 32));
+			dist = d + 1;
+			continue;
+		}
+		any = true;
+		uint64_t abs_slot = w->cursor + d;
+		uint64_t earliest = UINT64_MAX;
+		for (timeout_t *t = w->slots[idx]; t; t = t->next)
+			if (t->deadline >> TIMER_WHEEL_SLOT_SHIFT <= abs_slot && t->deadline < earliest)
+				earliest = t->deadline;
+		if (earliest != UINT64_MAX) {
+			set_cmp(w, earliest);
+			return;
+		}
+		dist = d + 1;
+	}
+	// Nothing due this revolution: wake up at the start of the next one
+	if (any)
+		set_cmp(w, (w->cursor + TIMER_WHEEL_SLOTS) << TIMER_WHEEL_SLOT_SHIFT);
+	else
+		set_cmp(w, UINT64_MAX);
+}
+
+void timer_wheel_init() {
+	wheel_t *w = &wheels[get_core_num()];
+	for (int i = 0; i < TIMER_WHEEL_SLOTS; ++i)
+		w->slots[i] = NULL;
+	for (int i = 0; i < BITMAP_WORDS; ++i)
+		w->occupied[i] = 0;
+	w->cursor = timer_get_time() >> TIMER_WHEEL_SLOT_SHIFT;
+	set_cmp(w, UINT64_MAX);
+
+	// MTIE, then global MIE
+	asm volatile ("csrs mie, %0" : : "r" (1u << 7));
+	asm volatile ("csrsi mstatus, 0x8");
+}
+
+void timer_wheel_irq() {
+	wheel_t *w = &wheels[get_core_num()];
+	uint64_t now = timer_get_time();
+	uint64_t now_slot = now >> TIMER_WHEEL_SLOT_SHIFT;
+
+	// Move expired timeouts to a local list first, so callbacks can freely
+	// add and cancel timeouts, including ones which are about to run.
+	timeout_t *expired = NULL;
+	uint64_t n_slots = now_slot - w->cursor + 1;
+	if (n_slots > TIMER_WHEEL_SLOTS)
+		n_slots = TIMER_WHEEL_SLOTS;
+	for (uint32_t i = 0; i < n_slots; ++i) {
+		uint32_t idx = (w->cursor + i) % TIMER_WHEEL_SLOTS;
+		if (!(w->occupied[idx / 32] & (1u << (idx % 32))))
+			continue;
+		timeout_t *next;
+		for (timeout_t *t = w->slots[idx]; t; t = next) {
+			next = t->next;
+			if (t->deadline <= now) {
+				list_remove(t);
+				list_push(&expired, t);
+			}
+		}
+		if (!w->slots[idx])
+			w->occupied[idx / 32] &= ~(1u << (idx % 32));
+	}
+	w->cursor = now_slot;
+
+	while (expired) {
+		timeout_t *t = expired;
+		list_remove(t);
+		t->callback(t);
+	}
+
+	reprogram(w);
+}
+
+void timeout_add(timeout_t *t, uint64_t deadline, timeout_callback_t callback) {
+	wheel_t *w = &wheels[get_core_num()];
+	t->deadline = deadline;
+	t->callback = callback;
+
+	uint32_t mstatus = irq_save();
+	uint64_t slot = deadline >> TIMER_WHEEL_SLOT_SHIFT;
+	// Already-expired timeouts go in the next slot to be visited
+	if (slot < w->cursor)
+		slot = w->cursor;
+	uint32_t idx = slot % TIMER_WHEEL_SLOTS;
+	list_push(&w->slots[idx], t);
+	w->occupied[idx / 32] |= 1u << (idx % 32);
+	if (deadline < w->cmp)
+		set_cmp(w, deadline);
+	irq_restore(mstatus);
+}
+
+bool timeout_cancel(timeout_t *t) {
+	uint32_t mstatus = irq_save();
+	bool pending = timeout_pending(t);
+	// Leave the comparator alone: at worst we get one spurious IRQ
+	if (pending)
+		list_remove(t);
+	irq_restore(mstatus);
+	return pending;
+}
+
+static void sleep_callback(timeout_t *t) {
+	*(volatile bool*)t->arg = true;
+}
+
+void sleep_until(uint64_t time) {
+	volatile bool done = false;
+	timeout_t t = {0};
+	t.arg = (void*)&done;
+	timeout_add(&t, time, sleep_callback);
+
+	// WFI with IRQs masked, so the wakeup can't be missed between checking
+	// done and sleeping. Pending IRQs still end the WFI, and are taken as
+	// soon as they are unmasked.
+	uint32_t mstatus = irq_save();
+	while (!done) {
+		__wfi();
+		asm volatile ("csrsi mstatus, 0x8\n csrci mstatus, 0x8" : : : "memory");
+	}
+	irq_restore(mstatus);
+}
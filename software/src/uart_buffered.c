@@ -0,0 +1,177 @@
+#include "uart_buffered.h"
+#include "multicore.h"
+
+#define N_CORES 2
+
+#if UART_TX_RING_SIZE & (UART_TX_RING_SIZE - 1) || UART_RX_RING_SIZE & (UART_RX_RING_SIZE - 1)
+#error "UART ring sizes must be powers of two"
+#endif
+
+// head is written only by the producer, and tail only by the consumer. Both
+// count up forever, and are masked when indexing the buffer. The rings live
+// in SDRAM, which is coherent between the cores (via the shared cache).
+typedef struct {
+	volatile uint32_t head;
+	volatile uint32_t tail;
+} ring_ctrl_t;
+
+static struct {
+	ring_ctrl_t ctrl;
+	uint8_t buf[UART_TX_RING_SIZE];
+} tx_ring[N_CORES];
+
+static struct {
+	ring_ctrl_t ctrl;
+	uint8_t buf[UART_RX_RING_SIZE];
+} rx_ring;
+
+// Only touched by the IRQ handler
+static int tx_current;
+static volatile uint32_t rx_dropped;
+
+static inline uint32_t ring_level(ring_ctrl_t *r) {
+	return __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+}
+
+static inline bool tx_rings_empty() {
+	for (int i = 0; i < N_CORES; ++i)
+		if (ring_level(&tx_ring[i].ctrl))
+			return false;
+	return true;
+}
+
+// The TX IRQ is only enabled while there is something to send. Producers set
+// TXIE after queueing data, and the handler clears it once the rings are
+// empty, then checks again in case a producer queued more in between.
+static inline void tx_irq_enable(bool en) {
+	if (en)
+		mm_uart->csr |= UART_CSR_TXIE_MASK;
+	else
+		mm_uart->csr &= ~UART_CSR_TXIE_MASK;
+}
+
+void uart_buffered_init() {
+	for (int i = 0; i < N_CORES; ++i)
+		tx_ring[i].ctrl.head = tx_ring[i].ctrl.tail = 0;
+	rx_ring.ctrl.head = rx_ring.ctrl.tail = 0;
+	tx_current = 0;
+	rx_dropped = 0;
+
+	mm_uart->csr |= UART_CSR_RXIE_MASK;
+	// Hazard3 per-IRQ enables are in meie0, then MEIE in mie, then global MIE
+	asm volatile ("csrs 0xbe0, %0" : : "r" (1u << UART_IRQ));
+	asm volatile ("csrs mie, %0" : : "r" (1u << 11));
+	asm volatile ("csrsi mstatus, 0x8");
+}
+
+void uart_buffered_irq() {
+	// RX: drain the FIFO, dropping data if the ring is full
+	uint32_t head = rx_ring.ctrl.head;
+	while (!uart_rx_empty()) {
+		uint8_t c = (uint8_t)mm_uart->rx;
+		if (head - __atomic_load_n(&rx_ring.ctrl.tail, __ATOMIC_ACQUIRE) < UART_RX_RING_SIZE) {
+			rx_ring.buf[head % UART_RX_RING_SIZE] = c;
+			++head;
+		} else {
+			++rx_dropped;
+		}
+	}
+	__atomic_store_n(&rx_ring.ctrl.head, head, __ATOMIC_RELEASE);
+
+	// TX: refill the FIFO, switching cores at the end of each line
+	while (!uart_tx_full()) {
+		ring_ctrl_t *r = &tx_ring[tx_current].ctrl;
+		if (!ring_level(r)) {
+			tx_current = (tx_current + 1) % N_CORES;
+			r = &tx_ring[tx_current].ctrl;
+			if (!ring_level(r))
+				break;
+		}
+		uint32_t tail = r->tail;
+		uint8_t c = tx_ring[tx_current].buf[tail % UART_TX_RING_SIZE];
+		__atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+		mm_uart->tx = c;
+		if (c == '\n')
+			tx_current = (tx_current + 1) % N_CORES;
+	}
+	if (tx_rings_empty()) {
+		tx_irq_enable(false);
+		if (!tx_rings_empty())
+			tx_irq_enable(true);
+	}
+}
+
+size_t uart_buffered_write_nonblocking(const uint8_t *data, size_t len) {
+	uint32_t core = get_core_num();
+	ring_ctrl_t *r = &tx_ring[core].ctrl;
+	uint8_t *buf = tx_ring[core].buf;
+	uint32_t head = r->head;
+	uint32_t space = UART_TX_RING_SIZE - (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE));
+	if (len > space)
+		len = space;
+	for (size_t i = 0; i < len; ++i)
+		buf[(head + i) % UART_TX_RING_SIZE] = data[i];
+	if (len) {
+		__atomic_store_n(&r->head, head + len, __ATOMIC_RELEASE);
+		tx_irq_enable(true);
+	}
+	return len;
+}
+
+void uart_buffered_write(const uint8_t *data, size_t len) {
+	while (len) {
+		size_t n = uart_buffered_write_nonblocking(data, len);
+		data += n;
+		len -= n;
+	}
+}
+
+void uart_buffered_putc(char c) {
+	uart_buffered_write((const uint8_t*)&c, 1);
+}
+
+void uart_buffered_puts(const char *s) {
+	// Send in runs, so the TX IRQ is kicked once per run rather than per byte
+	while (*s) {
+		const char *run = s;
+		while (*s && *s != '\n')
+			++s;
+		uart_buffered_write((const uint8_t*)run, s - run);
+		if (*s == '\n') {
+			uart_buffered_write((const uint8_t*)"\r\n", 2);
+			++s;
+		}
+	}
+}
+
+void uart_buffered_printf(const char *fmt, ...) {
+	char buf[PRINTF_BUF_SIZE];
+	va_list args;
+	va_start(args, fmt);
+	vsnprintf(buf, PRINTF_BUF_SIZE, fmt, args);
+	uart_buffered_puts(buf);
+	va_end(args);
+}
+
+int uart_buffered_getc() {
+	uint32_t tail = rx_ring.ctrl.tail;
+	if (__atomic_load_n(&rx_ring.ctrl.head, __ATOMIC_ACQUIRE) == tail)
+		return -1;
+	uint8_t c = rx_ring.buf[tail % UART_RX_RING_SIZE];
+	__atomic_store_n(&rx_ring.ctrl.tail, tail + 1, __ATOMIC_RELEASE);
+	return c;
+}
+
+size_t uart_buffered_rx_level() {
+	return ring_level(&rx_ring.ctrl);
+}
+
+uint32_t uart_buffered_rx_dropped() {
+	return rx_dropped;
+}
+
+void uart_buffered_flush() {
+	while (!tx_rings_empty())
+		;
+	uart_wait_done();
+}